@@ -8,6 +8,8 @@
 #include <ax/Window.h>
 #include <ax/UIElement.h>
 #include <ax/Observer.h>
+#include <ax/Responsiveness.h>
+#include <ax/FocusTracker.h>
 #include <Cocoa/Cocoa.h>
 #include <AppKit/AppKit.h>
 #include <string>
@@ -26,15 +28,29 @@ using namespace std;
 {
     vector<shared_ptr<ax::Application>> _applications;
     ax::UIElement _systemWideElement;
+    ax::ResponsivenessTracker _responsiveness;
+    ax::FocusTracker _focus;
     bool _needUpdate;
-    bool _updateFocus;
     @public ax::Window* _focusedWindow;
 }
 
 -(id)init;
 -(void)setNeedsUpdate;
--(void)focusMainWindow:(ax::Application*)app;
--(void)focusWindow:(ax::Window*)win focused:(bool)focused;
+-(bool)needsUpdate;
+-(void)applicationActivated:(ax::Application*)app;
+-(void)applicationDeactivated:(ax::Application*)app;
+-(void)applicationShown:(ax::Application*)app;
+-(void)applicationHidden:(ax::Application*)app;
+-(void)mainWindowChanged:(ax::Application*)app window:(ax::Window*)win;
+-(void)windowAdded:(ax::Window*)win;
+-(void)windowRemoved:(ax::Window*)win;
+-(const ax::FocusTracker&)focusTracker;
+-(int)updateApplication:(ax::Application*)app;
+-(const ax::ResponsivenessTracker&)responsiveness;
+-(ax::ObserverStats)observerStats;
+
+// logs observer, responsiveness and focus counters
+-(void)logStats;
 +(void)assertAccessibilityEnabled;
 
 -(void)applicationCreated:(ax::Application*)app;
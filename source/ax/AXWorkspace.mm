@@ -20,10 +20,10 @@ using namespace ax;
     if(self)
     {
         _focusedWindow = nullptr;
-        _updateFocus = false;
         _systemWideElement = UIElement::systemWideElement();
+        UIElement::setResponsivenessTracker(&_responsiveness);
         
-        float timeout = 0.1f;
+        float timeout = AX_DEFAULT_TIMEOUT;
         //float timeout = 3.0f;
         AXError err = _systemWideElement.setMessagingTimeout(timeout);
         if(err != kAXErrorSuccess)
@@ -47,9 +47,13 @@ using namespace ax;
             }
         }
         
-        int errors = [self updateFocusedWindow];
-        if(errors)
-            [self setNeedsUpdate];
+        NSRunningApplication* frontmost = [[NSWorkspace sharedWorkspace] frontmostApplication];
+        
+        if(frontmost && [self getApplication:frontmost])
+        {
+            _focus.activated([frontmost processIdentifier]);
+            [self updateFocus:true];
+        }
     }
     
     return self;
@@ -62,6 +66,7 @@ using namespace ax;
     [nc removeObserver:self name:NSWorkspaceDidTerminateApplicationNotification object:nil];
     
     _applications = vector<shared_ptr<Application>>();
+    UIElement::setResponsivenessTracker(nullptr);
     
     [super dealloc];
 }
@@ -76,14 +81,17 @@ using namespace ax;
         if((*it)->processID() == pid)
             break;
     }
-
+    
     return it;
 }
 
 -(ax::Application*)getApplication:(NSRunningApplication*)runningApp
 {
-    pid_t pid = [runningApp processIdentifier];
-    
+    return [self getApplicationForPID:[runningApp processIdentifier]];
+}
+
+-(ax::Application*)getApplicationForPID:(pid_t)pid
+{
     auto it = _applications.begin();
     
     for( ; it != _applications.end(); ++it) {
@@ -106,99 +114,209 @@ using namespace ax;
     {
         auto& app = *it;
         
-        errors += app->update();
+        errors += [self updateApplication:app.get()];
         
         if(app->state() == State::Invalid)
+        {
+            pid_t pid = app->processID();
+            _responsiveness.remove(pid);
+            _focus.terminated(pid);
+            [self updateFocus:false];
             it = _applications.erase(it);
+        }
         else
+        {
             ++it;
+        }
     }
     
-    if(_updateFocus)
-        errors += [self updateFocusedWindow];
+    if(_focus.needsQuery())
+    {
+        if(!_focus.resolve([self focusResolver]))
+            ++errors;
+        
+        [self updateFocus:false];
+    }
     
     if(errors)
         [self setNeedsUpdate];
 }
 
--(void)focusMainWindow:(ax::Application*)app
+-(int)updateApplication:(ax::Application*)app
 {
-    try
+    pid_t pid = app->processID();
+    Health before = _responsiveness.state(pid);
+    
+    int errors = 0;
+    
+    // while the circuit is open, the app keeps its last known windows,
+    // and an error is reported so that the retry loop will probe it later.
+    if(_responsiveness.shouldQuery(pid))
     {
-        Attribute mainWindowAttrib = app->element().attributeFor(kAXMainWindowAttribute);
-        if(!mainWindowAttrib)
-            throw runtime_error("failed to get main window attrib");
-        
-        UIElement mainWindow = mainWindowAttrib.elementRefValue();
-        if(!mainWindow)
-            throw runtime_error("failed to get main window element");
-        
-        ax::Window* win = app->getWindow(mainWindow);
-        
-        if(_focusedWindow != win)
-        {
-            if(_focusedWindow)
-                [self windowFocusChanged:_focusedWindow focused:false];
-            
-            if(win)
-                [self windowFocusChanged:win focused:true];
-            
-            _focusedWindow = win;
-        }
-        
-        _updateFocus = false;
+        app->setMessagingTimeout(_responsiveness.timeoutFor(pid));
+        errors = app->update();
     }
-    catch(exception& ex)
+    else
     {
-        _updateFocus = true;
-        [self setNeedsUpdate];
+        ++errors;
     }
+    
+    Health after = _responsiveness.state(pid);
+    
+    if(before != after && (before == Health::Unresponsive || after == Health::Unresponsive))
+        cout << "application " << to_string(after) << ": " << app->title() << endl;
+    
+    return errors;
+}
+
+-(const ax::ResponsivenessTracker&)responsiveness
+{
+    return _responsiveness;
+}
+
+-(ax::ObserverStats)observerStats
+{
+    return Observer::stats();
+}
+
+-(void)logStats
+{
+    ObserverStats obs = Observer::stats();
+    double meanDispatch = obs.callbacks ? obs.dispatchTime / obs.callbacks : 0;
+    
+    cout << "observers: " << obs.observers
+         << ", subscriptions: " << obs.subscriptions
+         << ", callbacks: " << obs.callbacks
+         << ", mean dispatch: " << meanDispatch * 1000.0 << "ms"
+         << ", max dispatch: " << obs.maxDispatchTime * 1000.0 << "ms" << endl;
+    
+    _responsiveness.forEach([self](pid_t pid, const AppHealth& health)
+    {
+        Application* app = [self getApplicationForPID:pid];
+        
+        cout << "  " << (app ? app->title() : std::to_string(pid))
+             << ": " << to_string(health.state)
+             << ", timeout: " << health.timeout * 1000.0f << "ms"
+             << ", p99: " << health.p99 * 1000.0 << "ms"
+             << ", timeouts: " << health.timeouts
+             << ", skipped: " << health.skipped
+             << ", subscriptions: " << (app ? app->observer().subscriptionCount() : 0) << endl;
+    });
+    
+    cout << "focus: " << _focus.focusChanges() << " changes, "
+         << _focus.queries() << " main window queries" << endl;
+}
+
+-(const ax::FocusTracker&)focusTracker
+{
+    return _focus;
 }
 
--(void)focusWindow:(ax::Window*)win focused:(bool)focused
+// Queries the main window of the frontmost app, when the focus tracker can't tell which it is.
+-(FocusTracker::Resolver)focusResolver
 {
-    try
+    return [self](pid_t pid, const void *&window)
     {
-        if(focused)
+        Application* app = [self getApplicationForPID:pid];
+        if(!app)
+            return FocusTracker::MainWindow::None;
+        
+        AXError err;
+        Attribute mainWindowAttrib = app->element().attributeFor(kAXMainWindowAttribute, &err);
+        
+        if(err != kAXErrorSuccess && err != kAXErrorNoValue)
+            return FocusTracker::MainWindow::Unknown;
+        
+        if(mainWindowAttrib)
         {
-            if(win == nullptr)
-                throw runtime_error("window is null");
-            
-            Attribute mainAttrib = win->element().attributeFor(kAXMainAttribute);
-            if(!mainAttrib)
-                throw runtime_error("failed to get main attrib");
-            
-            if(mainAttrib.boolValue())
+            Window* win = app->getWindow(mainWindowAttrib.elementRefValue());
+            if(win && win->state() == State::Valid)
             {
-                if(_focusedWindow != win)
-                {
-                    if(_focusedWindow)
-                        [self windowFocusChanged:_focusedWindow focused:false];
-                    
-                    if(win)
-                        [self windowFocusChanged:win focused:true];
-                    
-                    _focusedWindow = win;
-                }
+                window = win;
+                return FocusTracker::MainWindow::Found;
             }
         }
-        else
+        
+        // a window that is still being set up may turn out to be the main window
+        for(auto& win : app->windows())
         {
-            if(win && _focusedWindow == win)
-            {
-                [self windowFocusChanged:win focused:false];
-                _focusedWindow = nullptr;
-            }
+            if(win->state() == State::Pending)
+                return FocusTracker::MainWindow::Unknown;
         }
         
-        _updateFocus = false;
-    }
-    catch(exception& ex)
-    {
-        cout << ex.what() << endl;
-        _updateFocus = true;
+        // no main window, or one that isn't on the taskbar, like a panel
+        return FocusTracker::MainWindow::None;
+    };
+}
+
+// Notifies the focus change, if any, after the focus tracker has settled.
+-(void)updateFocus:(bool)resolveNow
+{
+    if(_focus.settle(resolveNow, [self focusResolver]))
         [self setNeedsUpdate];
+    
+    const void* previous = nullptr;
+    
+    if(_focus.takeFocusChange(previous))
+    {
+        Window* win = (Window*)_focus.focused();
+        
+        if(previous)
+            [self windowFocusChanged:(Window*)previous focused:false];
+        
+        if(win)
+            [self windowFocusChanged:win focused:true];
+        
+        _focusedWindow = win;
     }
+
+#if DEBUG
+    string violation = _focus.checkInvariants();
+    if(!violation.empty())
+        cout << "focus invariant violated: " << violation << endl;
+#endif
+}
+
+-(void)applicationActivated:(ax::Application*)app
+{
+    _focus.activated(app->processID());
+    [self updateFocus:true];
+}
+
+-(void)applicationDeactivated:(ax::Application*)app
+{
+    _focus.deactivated(app->processID());
+    [self updateFocus:true];
+}
+
+-(void)applicationShown:(ax::Application*)app
+{
+    _focus.shown(app->processID());
+    [self updateFocus:true];
+}
+
+-(void)applicationHidden:(ax::Application*)app
+{
+    _focus.hidden(app->processID());
+    [self updateFocus:true];
+}
+
+-(void)mainWindowChanged:(ax::Application*)app window:(ax::Window*)win
+{
+    _focus.mainWindowChanged(app->processID(), win);
+    [self updateFocus:true];
+}
+
+-(void)windowAdded:(ax::Window*)win
+{
+    _focus.windowAdded(win->app()->processID(), win);
+    [self updateFocus:true];
+}
+
+-(void)windowRemoved:(ax::Window*)win
+{
+    _focus.windowDestroyed(win->app()->processID(), win);
+    [self updateFocus:false];
 }
 
 +(void)assertAccessibilityEnabled
@@ -210,7 +328,7 @@ using namespace ax;
     NSDictionary *options = @{ (id)kAXTrustedCheckOptionPrompt: @YES };
     BOOL axEnabled = AXIsProcessTrustedWithOptions((CFDictionaryRef)options);
 #endif
-    
+
     if(!axEnabled)
     {
         [[NSWorkspace sharedWorkspace] openFile:@"/System/Library/PreferencePanes/Security.prefPane"];
@@ -219,56 +337,6 @@ using namespace ax;
     }
 }
 
--(int)updateFocusedWindow
-{
-    int errors = 0;
-    
-    try
-    {
-        NSWorkspace* ws = [NSWorkspace sharedWorkspace];
-        NSRunningApplication* runningApp = [ws frontmostApplication];
-        
-        if(runningApp != nullptr && runningApp.activationPolicy == NSApplicationActivationPolicyRegular)
-        {
-            Application* app = [self getApplication:runningApp];
-            if(!app)
-                throw runtime_error("cound't find ax::Application for running app: "s + [[runningApp localizedName] UTF8String]);
-            
-            Attribute mainWindowAttrib = app->element().attributeFor(kAXMainWindowAttribute);
-            if(!mainWindowAttrib)
-                throw runtime_error("couldn't get kAXMainWindowAttribute: "s + app->title());
-            
-            UIElement mainWindow = mainWindowAttrib.elementRefValue();
-            if(!mainWindow)
-                throw runtime_error("mainWindow element is empty: "s + app->title());
-            
-            Window* win = app->getWindow(mainWindow);
-            if(!win)
-                throw runtime_error("couldn't find window for mainWindow windowRef: "s + app->title());
-            
-            if(_focusedWindow != win)
-            {
-                if(_focusedWindow)
-                    [self windowFocusChanged:_focusedWindow focused:false];
-                
-                if(win)
-                    [self windowFocusChanged:win focused:true];
-                
-                _focusedWindow = win;
-            }
-        }
-        
-        _updateFocus = false;
-    }
-    catch(exception& ex)
-    {
-        cout << ex.what() << endl;
-        ++errors;
-    }
-    
-    return errors;
-};
-
 -(void)onAppLaunched:(NSNotification*)notification
 {
     NSRunningApplication *runningApp = [[notification userInfo] objectForKey:NSWorkspaceApplicationKey];
@@ -279,7 +347,10 @@ using namespace ax;
             auto app = make_shared<ax::Application>(self, runningApp);
             _applications.push_back(app);
             
-            int errors = app->update();
+            if(runningApp.hidden)
+                _focus.hidden(app->processID());
+            
+            int errors = [self updateApplication:app.get()];
             if(errors)
                 [self setNeedsUpdate];
         }
@@ -294,6 +365,10 @@ using namespace ax;
         auto it = [self findApplication:runningApp];
         if(it != _applications.end())
         {
+            pid_t pid = (*it)->processID();
+            _responsiveness.remove(pid);
+            _focus.terminated(pid);
+            [self updateFocus:false];
             _applications.erase(it);
         }
     }
@@ -308,6 +383,11 @@ using namespace ax;
     }
 }
 
+-(bool)needsUpdate
+{
+    return _needUpdate;
+}
+
 -(void)applicationCreated:(ax::Application*)app{}
 -(void)applicationDestroyed:(ax::Application*)app{}
 -(void)windowCreated:(ax::Window*)window{}
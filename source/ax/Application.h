@@ -7,6 +7,7 @@
 #include <ax/UIElement.h>
 #include <ax/Observer.h>
 #include <ax/Window.h>
+#include <ax/Responsiveness.h>
 #include <Cocoa/Cocoa.h>
 #include <AppKit/AppKit.h>
 #include <vector>
@@ -53,6 +54,10 @@ public:
     State state() const;
     void setDirty();
     
+    // applies to the application element and all of its windows
+    void setMessagingTimeout(float seconds);
+    float messagingTimeout() const;
+    
     void hide();
     void quit();
     void force_quit();
@@ -63,6 +68,9 @@ public:
     
 private:
     
+    // finds the window by its observer route, falling back to a search
+    Window* windowFor(const UIElement& element);
+    
     void onAppShown(UIElement element);
     void onAppHidden(UIElement element);
     void onAppActivated(UIElement element);
@@ -89,6 +97,7 @@ private:
     AXWorkspace *_workspace;
     State _state;
     bool _dirty;
+    float _timeout;
 };
 
 }
@@ -19,7 +19,8 @@ Application::Application()
       _hidden(false),
       _workspace(nullptr),
       _state(State::Pending),
-      _dirty(false)
+      _dirty(false),
+      _timeout(0)
 {
     
 }
@@ -39,7 +40,8 @@ Application::Application(AXWorkspace *ws, NSRunningApplication *app)
       _hidden(app.hidden),
       _workspace(ws),
       _state(State::Pending),
-      _dirty(false)
+      _dirty(false),
+      _timeout(0)
 {
     
 }
@@ -56,7 +58,8 @@ Application::Application(Application &&other)
       _hidden(other._hidden),
       _workspace(other._workspace),
       _state(other._state),
-      _dirty(other._dirty)
+      _dirty(other._dirty),
+      _timeout(other._timeout)
 {
     other._pid = 0;
     other._icon = nil;
@@ -64,6 +67,7 @@ Application::Application(Application &&other)
     other._workspace = nullptr;
     other._state = State::Pending;
     other._dirty = false;
+    other._timeout = 0;
 }
 
 Application& Application::operator=(Application &&other)
@@ -80,6 +84,7 @@ Application& Application::operator=(Application &&other)
     _workspace = other._workspace;
     _state = other._state;
     _dirty = other._dirty;
+    _timeout = other._timeout;
     
     other._pid = 0;
     other._icon = nil;
@@ -87,6 +92,7 @@ Application& Application::operator=(Application &&other)
     other._workspace = nullptr;
     other._state = State::Pending;
     other._dirty = false;
+    other._timeout = 0;
     
     return *this;
 }
@@ -192,7 +198,7 @@ int Application::update()
         
         if(win->state() == State::Invalid)
         {
-            [_workspace focusWindow:it->get() focused:false];
+            [_workspace windowRemoved:it->get()];
             it = _windows.erase(it);
         }
         else
@@ -214,12 +220,35 @@ void Application::setDirty()
     _dirty = true;
 }
 
+void Application::setMessagingTimeout(float seconds)
+{
+    if(seconds == _timeout)
+        return;
+    
+    _timeout = seconds;
+    _element.setMessagingTimeout(seconds);
+    
+    for(auto& win : _windows)
+        win->_element.setMessagingTimeout(seconds);
+}
+
+float Application::messagingTimeout() const
+{
+    return _timeout;
+}
+
 Window* Application::getWindow(const UIElement& element)
 {
     auto it = findWindow(element);
     return (it != _windows.end()) ? it->get() : nullptr;
 }
     
+Window* Application::windowFor(const UIElement& element)
+{
+    Window* win = _observer.target(element);
+    return win ? win : getWindow(element);
+}
+
 vector<shared_ptr<Window>>::iterator Application::findWindow(const UIElement& element)
 {
     auto it = _windows.begin();
@@ -256,10 +285,7 @@ void Application::onAppShown(UIElement element)
             win->createWindow();
     }
     
-    if(runningApplication().active)
-    {
-        [_workspace focusMainWindow:this];
-    }
+    [_workspace applicationShown:this];
 }
 
 void Application::onAppHidden(UIElement element)
@@ -268,36 +294,32 @@ void Application::onAppHidden(UIElement element)
     
     _hidden = true;
     
+    [_workspace applicationHidden:this];
+    
     for(auto& win : _windows)
     {
         if(win->state() == State::Valid)
-        {
-            [_workspace focusWindow:win.get() focused:false];
             win->destroyWindow();
-        }
     }
 }
 
 void Application::onAppActivated(UIElement element)
 {
     //cout << "APP: onAppActivated: " << _title << endl;
-    [_workspace focusMainWindow:this];
+    [_workspace applicationActivated:this];
 }
 
 void Application::onAppDeactivated(UIElement element)
 {
     //cout << "APP: onAppDeactivated: " << _title << endl;
+    [_workspace applicationDeactivated:this];
 }
 
 void Application::onFocusChanged(UIElement element)
 {
     //cout << "APP: onFocusChanged: " << _title << endl;
     
-    if(runningApplication().active)
-    {
-        ax::Window* win = getWindow(element);
-        if(win) [_workspace focusWindow:win focused:true];
-    }
+    [_workspace mainWindowChanged:this window:windowFor(element)];
 }
 
 void Application::onWindowCreated(UIElement element)
@@ -320,21 +342,19 @@ void Application::onWindowDestroyed(UIElement element)
 {
     //cout << "APP: onWindowDestroyed: " << _title << endl;
     
-    auto it = findWindow(element);
+    auto it = findWindow(windowFor(element));
     if(it != _windows.end())
     {
-        [_workspace focusWindow:it->get() focused:false];
+        [_workspace windowRemoved:it->get()];
         _windows.erase(it);
     }
 }
 
 void Application::onWindowResized(UIElement element)
 {
-    auto it = findWindow(element);
-    if(it != _windows.end())
+    Window* win = windowFor(element);
+    if(win)
     {
-        Window* win = it->get();
-        
         // make sure the window is not hiding behind the taskbar
         CGPoint pos = win->position();
         CGSize sz = win->size();
@@ -356,17 +376,16 @@ void Application::onWindowResized(UIElement element)
 
 void Application::onWindowMoved(UIElement element)
 {
-    auto it = findWindow(element);
-    if(it != _windows.end())
-        [_workspace windowMoved:it->get()];
+    Window* win = windowFor(element);
+    if(win)
+        [_workspace windowMoved:win];
 }
 
 void Application::onWindowTitleChanged(UIElement element)
 {
-    auto it = findWindow(element);
-    if(it != _windows.end())
+    Window* win = windowFor(element);
+    if(win)
     {
-        auto& win = *it;
         win->setDirty();
         if(win->update() != 0)
             [_workspace setNeedsUpdate];
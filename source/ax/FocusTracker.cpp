@@ -0,0 +1,286 @@
+/*---------------------------------------------------------------------------------------------
+ *  Copyright (c) Nicolas Jinchereau. All rights reserved.
+ *  Licensed under the MIT License. See License.txt in the project root for license information.
+ *--------------------------------------------------------------------------------------------*/
+
+#include <ax/FocusTracker.h>
+
+namespace ax
+{
+
+FocusTracker::FocusTracker()
+    : _frontmost(0),
+      _focused(nullptr),
+      _reported(nullptr),
+      _events(0),
+      _queries(0),
+      _focusChanges(0)
+{
+    
+}
+
+void FocusTracker::activated(pid_t pid)
+{
+    _apps[pid];
+    _frontmost = pid;
+    _update();
+}
+
+void FocusTracker::deactivated(pid_t pid)
+{
+    if(_frontmost == pid)
+        _frontmost = 0;
+    
+    _update();
+}
+
+void FocusTracker::shown(pid_t pid)
+{
+    _apps[pid].hidden = false;
+    _update();
+}
+
+void FocusTracker::hidden(pid_t pid)
+{
+    _apps[pid].hidden = true;
+    _update();
+}
+
+void FocusTracker::terminated(pid_t pid)
+{
+    _apps.erase(pid);
+    
+    for(auto it = _owners.begin(); it != _owners.end(); )
+    {
+        if(it->second == pid)
+            it = _owners.erase(it);
+        else
+            ++it;
+    }
+    
+    if(_frontmost == pid)
+        _frontmost = 0;
+    
+    _update();
+}
+
+void FocusTracker::mainWindowChanged(pid_t pid, const void *window)
+{
+    AppState& app = _apps[pid];
+    
+    if(window)
+    {
+        _owners[window] = pid;
+        app.known = true;
+        app.main = window;
+    }
+    else
+    {
+        app.known = false;
+        app.main = nullptr;
+    }
+    
+    _update();
+}
+
+void FocusTracker::windowAdded(pid_t pid, const void *window)
+{
+    _owners[window] = pid;
+    
+    // the new window may become the main window of an app that had none
+    // tracked, without saying so
+    AppState& app = _apps[pid];
+    if(app.known && app.main == nullptr)
+        app.known = false;
+    
+    _update();
+}
+
+void FocusTracker::windowDestroyed(pid_t pid, const void *window)
+{
+    _owners.erase(window);
+    
+    auto it = _apps.find(pid);
+    if(it != _apps.end() && it->second.main == window)
+    {
+        it->second.known = false;
+        it->second.main = nullptr;
+    }
+    
+    _update();
+}
+
+void FocusTracker::resolved(pid_t pid, const void *window)
+{
+    ++_queries;
+    
+    AppState& app = _apps[pid];
+    app.known = true;
+    app.main = window;
+    
+    if(window)
+        _owners[window] = pid;
+    
+    _update();
+}
+
+void FocusTracker::unresolved(pid_t)
+{
+    ++_queries;
+    _update();
+}
+
+bool FocusTracker::resolve(const Resolver &resolver)
+{
+    pid_t pid = ambiguousApp();
+    if(pid == 0)
+        return true;
+    
+    const void *window = nullptr;
+    
+    switch(resolver(pid, window))
+    {
+        case MainWindow::Found:
+            resolved(pid, window);
+            return true;
+        
+        case MainWindow::None:
+            resolved(pid, nullptr);
+            return true;
+        
+        case MainWindow::Unknown:
+            break;
+    }
+    
+    unresolved(pid);
+    return false;
+}
+
+bool FocusTracker::settle(bool resolveNow, const Resolver &resolver)
+{
+    if(!needsQuery())
+        return false;
+    
+    return !resolveNow || !resolve(resolver);
+}
+
+bool FocusTracker::takeFocusChange(const void *&previous)
+{
+    if(_reported == _focused)
+        return false;
+    
+    previous = _reported;
+    _reported = _focused;
+    return true;
+}
+
+const void* FocusTracker::focused() const
+{
+    return _focused;
+}
+
+pid_t FocusTracker::frontmost() const
+{
+    return _frontmost;
+}
+
+pid_t FocusTracker::ambiguousApp() const
+{
+    if(_frontmost == 0)
+        return 0;
+    
+    auto it = _apps.find(_frontmost);
+    if(it == _apps.end() || it->second.hidden || it->second.known)
+        return 0;
+    
+    return _frontmost;
+}
+
+bool FocusTracker::needsQuery() const
+{
+    return ambiguousApp() != 0;
+}
+
+uint64_t FocusTracker::events() const
+{
+    return _events;
+}
+
+uint64_t FocusTracker::queries() const
+{
+    return _queries;
+}
+
+uint64_t FocusTracker::focusChanges() const
+{
+    return _focusChanges;
+}
+
+const void* FocusTracker::_expectedFocus() const
+{
+    if(_frontmost == 0)
+        return nullptr;
+    
+    auto it = _apps.find(_frontmost);
+    if(it == _apps.end() || it->second.hidden || !it->second.known)
+        return nullptr;
+    
+    return it->second.main;
+}
+
+void FocusTracker::_update()
+{
+    ++_events;
+    
+    const void *focused = _expectedFocus();
+    
+    if(focused != _focused)
+    {
+        _focused = focused;
+        ++_focusChanges;
+    }
+}
+
+string FocusTracker::checkInvariants() const
+{
+    if(_frontmost != 0 && _apps.find(_frontmost) == _apps.end())
+        return "frontmost app is not tracked";
+    
+    for(auto& kv : _owners)
+    {
+        if(_apps.find(kv.second) == _apps.end())
+            return "window is owned by an app that is not tracked";
+    }
+    
+    if(_focused)
+    {
+        auto it = _owners.find(_focused);
+        if(it == _owners.end())
+            return "focused window was destroyed";
+        
+        if(it->second != _frontmost)
+            return "focused window does not belong to the frontmost app";
+    }
+    
+    for(auto& kv : _apps)
+    {
+        const AppState& app = kv.second;
+        
+        if(!app.known && app.main)
+            return "unknown main window is not null";
+        
+        if(app.main)
+        {
+            auto it = _owners.find(app.main);
+            if(it == _owners.end() || it->second != kv.first)
+                return "main window is not owned by its app";
+        }
+    }
+    
+    if(needsQuery() && _focused)
+        return "focus is ambiguous, but a window is focused";
+    
+    return string();
+}
+
+}
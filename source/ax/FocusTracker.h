@@ -0,0 +1,110 @@
+/*---------------------------------------------------------------------------------------------
+ *  Copyright (c) Nicolas Jinchereau. All rights reserved.
+ *  Licensed under the MIT License. See License.txt in the project root for license information.
+ *--------------------------------------------------------------------------------------------*/
+
+#pragma once
+#include <sys/types.h>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+using namespace std;
+
+namespace ax
+{
+
+// Tracks the focused window from app and window notifications alone.
+//
+// Each app remembers its last known main window. The focused window is the
+// main window of the frontmost app, unless that app is hidden. The state is
+// only ambiguous when the frontmost app's main window is not known, which
+// is the only time the main window needs to be queried over AX.
+//
+// Windows are opaque keys (ie. ax::Window*), and null means "no window".
+class FocusTracker
+{
+public:
+    // the outcome of querying an app's main window
+    enum class MainWindow
+    {
+        Found,   // 'window' was set to the tracked main window
+        None,    // the app has no main window that is tracked, eg. it is a panel
+        Unknown  // the query failed, or a window still being set up may be the main window
+    };
+    
+    // queries the main window of 'pid', setting 'window' if it was found
+    typedef function<MainWindow(pid_t pid, const void *&window)> Resolver;
+    
+    FocusTracker();
+    
+    void activated(pid_t pid);
+    void deactivated(pid_t pid);
+    void shown(pid_t pid);
+    void hidden(pid_t pid);
+    void terminated(pid_t pid);
+    
+    // 'window' is null if the new main window is not tracked (yet)
+    void mainWindowChanged(pid_t pid, const void *window);
+    
+    void windowAdded(pid_t pid, const void *window);
+    void windowDestroyed(pid_t pid, const void *window);
+    
+    // the result of querying the main window of 'pid', which is null if none is tracked
+    void resolved(pid_t pid, const void *window);
+    
+    // a query for the main window of 'pid' failed, and should be retried
+    void unresolved(pid_t pid);
+    
+    // Queries the main window of the ambiguous app, if any, through 'resolver'.
+    // Returns false if the state is still ambiguous, and the query should be retried.
+    bool resolve(const Resolver &resolver);
+    
+    // Called after each event. If the state is ambiguous, the main window is queried now,
+    // or if 'resolveNow' is false, on the next retry, which gives pending notifications a
+    // chance to resolve it first. Returns true if a retry is needed.
+    bool settle(bool resolveNow, const Resolver &resolver);
+    
+    // Returns true once for each change of the focused window since the last call,
+    // with the window that was focused before. That window may have been destroyed
+    // since, so it should only be compared, never dereferenced.
+    bool takeFocusChange(const void *&previous);
+    
+    const void* focused() const;
+    pid_t frontmost() const;
+    
+    // the app whose main window must be queried, or 0 if the state is not ambiguous
+    pid_t ambiguousApp() const;
+    bool needsQuery() const;
+    
+    uint64_t events() const;
+    uint64_t queries() const;
+    uint64_t focusChanges() const;
+    
+    // returns an empty string if all invariants hold, or a description of the first violation
+    string checkInvariants() const;
+
+private:
+    struct AppState
+    {
+        bool hidden = false;
+        
+        // false until the main window has been reported or queried
+        bool known = false;
+        const void *main = nullptr;
+    };
+    
+    const void* _expectedFocus() const;
+    void _update();
+    
+    unordered_map<pid_t, AppState> _apps;
+    unordered_map<const void*, pid_t> _owners;
+    pid_t _frontmost;
+    const void *_focused;
+    const void *_reported;
+    uint64_t _events;
+    uint64_t _queries;
+    uint64_t _focusChanges;
+};
+
+}
@@ -20,7 +20,24 @@ namespace ax
 
 class UIElement;
 class Application;
+class Window;
 
+struct ObserverStats
+{
+    // live AXObservers, each with its run loop source on the main run loop
+    size_t observers = 0;
+    
+    // live element/notification registrations, across all observers
+    size_t subscriptions = 0;
+    
+    // callbacks dispatched, and the time spent dispatching them (seconds)
+    uint64_t callbacks = 0;
+    double dispatchTime = 0;
+    double maxDispatchTime = 0;
+};
+
+// One AXObserver per application. Windows subscribe their elements to their
+// application's observer, and notifications are routed back to them by element.
 class Observer
 {
 public:
@@ -44,11 +61,16 @@ public:
     inline friend bool operator!=(const Observer &x, const Observer &y);
     inline friend bool operator!=(const Observer &x, nullptr_t);
     
-    bool addNotification(const UIElement &element, CFStringRef notification);
+    // 'target' is the window notifications for 'element' are routed to, if any
+    bool addNotification(const UIElement &element, CFStringRef notification, Window *target = nullptr);
     void removeNotification(const UIElement &element, CFStringRef notification);
     void removeNotifications(const UIElement &element);
     bool hasNotification(const UIElement &element, CFStringRef notification);
     bool hasNotifications(const UIElement &element);
+    Window* target(const UIElement &element) const;
+    size_t subscriptionCount() const;
+    
+    static ObserverStats stats();
     
 private:
     Observer(const Observer &other);
@@ -65,7 +87,10 @@ private:
         }
     };
     
+    void _release();
+    
     std::unordered_multimap<UIElement, CFStringRef, ElemHash> _callbacks;
+    std::unordered_map<UIElement, Window*, ElemHash> _targets;
     
     AXObserverRef _observer_ref;
     Application *_app;
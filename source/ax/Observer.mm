@@ -7,17 +7,28 @@
 #include <ax/UIElement.h>
 #include <ax/Application.h>
 #include <iostream>
+#include <algorithm>
+#include <chrono>
 #include <CoreFoundation/CoreFoundation.h>
 
 namespace ax
 {
 
+static ObserverStats _stats;
+
+ObserverStats Observer::stats()
+{
+    return _stats;
+}
+
 bool strEqual(CFStringRef notification, CFStringRef notifType) {
     return CFStringCompare(notification, notifType, 0) == 0;
 }
     
 void Observer::_proxy(AXObserverRef observer, AXUIElementRef element, CFStringRef notification, void *userdata)
 {
+    auto start = chrono::steady_clock::now();
+    
     Application *app = (Application*)userdata;
     
     if(strEqual(notification, kAXApplicationShownNotification)) {
@@ -54,6 +65,11 @@ void Observer::_proxy(AXObserverRef observer, AXUIElementRef element, CFStringRe
     else {
         cout << "warning: notification not implemented in Observer" << endl;
     }
+    
+    double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    ++_stats.callbacks;
+    _stats.dispatchTime += elapsed;
+    _stats.maxDispatchTime = max(_stats.maxDispatchTime, elapsed);
 }
 
 Observer::Observer()
@@ -69,52 +85,80 @@ Observer::Observer(Application *app)
     AXError err = AXObserverCreate(pid, &Observer::_proxy, &_observer_ref);
     
     if(err == 0)
+    {
         CFRunLoopAddSource(CFRunLoopGetMain(), AXObserverGetRunLoopSource(_observer_ref), kCFRunLoopDefaultMode);
+        ++_stats.observers;
+    }
     else
+    {
+        _observer_ref = nullptr;
         cout << "failed to created observer: " << err << endl;
+    }
 }
 
 Observer::Observer(Observer &&other)
     : _observer_ref(other._observer_ref),
       _app(other._app),
-      _callbacks(move(other._callbacks))
+      _callbacks(move(other._callbacks)),
+      _targets(move(other._targets))
 {
     other._observer_ref = nullptr;
     other._app = nullptr;
+    other._callbacks.clear();
+    other._targets.clear();
 }
 
 Observer::~Observer()
 {
-    if(_observer_ref) CFRelease(_observer_ref);
+    _release();
 }
 
-Observer& Observer::operator=(nullptr_t)
+void Observer::_release()
 {
-    if(_observer_ref) CFRelease(_observer_ref);
+    _stats.subscriptions -= _callbacks.size();
+    _callbacks.clear();
+    _targets.clear();
     
-    _observer_ref = nullptr;
+    if(_observer_ref)
+    {
+        CFRunLoopRemoveSource(CFRunLoopGetMain(), AXObserverGetRunLoopSource(_observer_ref), kCFRunLoopDefaultMode);
+        CFRelease(_observer_ref);
+        _observer_ref = nullptr;
+        
+        --_stats.observers;
+    }
+}
+
+Observer& Observer::operator=(nullptr_t)
+{
+    _release();
     _app = nullptr;
-    _callbacks.clear();
     
     return *this;
 }
 
 Observer& Observer::operator=(Observer &&other)
 {
-    if(_observer_ref) CFRelease(_observer_ref);
+    _release();
     
     _observer_ref = other._observer_ref;
     _app = other._app;
     _callbacks = move(other._callbacks);
+    _targets = move(other._targets);
     
     other._observer_ref = nullptr;
     other._app = nullptr;
+    other._callbacks.clear();
+    other._targets.clear();
     
     return *this;
 }
 
-bool Observer::addNotification(const UIElement &element, CFStringRef notification)
+bool Observer::addNotification(const UIElement &element, CFStringRef notification, Window *target)
 {
+    if(target)
+        _targets[element] = target;
+    
     if(hasNotification(element, notification))
         return true;
     
@@ -127,6 +171,7 @@ bool Observer::addNotification(const UIElement &element, CFStringRef notificatio
         return false;
     
     _callbacks.insert(make_pair(element, notification));
+    ++_stats.subscriptions;
     
     return true;
 }
@@ -142,9 +187,13 @@ void Observer::removeNotification(const UIElement &element, CFStringRef notifica
         if(strEqual(it->second, notification))
         {
             _callbacks.erase(it);
+            --_stats.subscriptions;
             break;
         }
     }
+    
+    if(!hasNotifications(element))
+        _targets.erase(element);
 }
 
 void Observer::removeNotifications(const UIElement &element)
@@ -155,7 +204,10 @@ void Observer::removeNotifications(const UIElement &element)
     {
         AXObserverRemoveNotification(_observer_ref, it->first._element_ref, it->second);
         it = _callbacks.erase(it);
+        --_stats.subscriptions;
     }
+    
+    _targets.erase(element);
 }
 
 bool Observer::hasNotification(const UIElement &element, CFStringRef notification)
@@ -176,4 +228,15 @@ bool Observer::hasNotifications(const UIElement &element)
     return range.first != range.second;
 }
 
+Window* Observer::target(const UIElement &element) const
+{
+    auto it = _targets.find(element);
+    return it != _targets.end() ? it->second : nullptr;
+}
+
+size_t Observer::subscriptionCount() const
+{
+    return _callbacks.size();
+}
+
 }
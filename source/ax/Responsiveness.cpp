@@ -0,0 +1,275 @@
+/*---------------------------------------------------------------------------------------------
+ *  Copyright (c) Nicolas Jinchereau. All rights reserved.
+ *  Licensed under the MIT License. See License.txt in the project root for license information.
+ *--------------------------------------------------------------------------------------------*/
+
+#include <ax/Responsiveness.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace ax
+{
+
+constexpr int LatencyHistogram::BucketCount;
+constexpr double LatencyHistogram::FirstBucketLimit;
+constexpr int ResponsivenessTracker::FailureThreshold;
+constexpr uint32_t ResponsivenessTracker::MinSamples;
+constexpr double ResponsivenessTracker::TimeoutScale;
+constexpr double ResponsivenessTracker::DegradedLatency;
+constexpr double ResponsivenessTracker::MinProbeInterval;
+constexpr double ResponsivenessTracker::MaxProbeInterval;
+constexpr uint32_t ResponsivenessTracker::DecayThreshold;
+
+std::string to_string(Health health)
+{
+    switch(health)
+    {
+        case Health::Healthy:
+            return "Healthy";
+
+        case Health::Degraded:
+            return "Degraded";
+
+        case Health::Unresponsive:
+            return "Unresponsive";
+
+        case Health::Probing:
+            return "Probing";
+
+        default:
+            return "Invalid Health";
+    }
+}
+
+////////////////
+// LatencyHistogram
+
+LatencyHistogram::LatencyHistogram()
+    : _count(0)
+{
+    fill(begin(_buckets), end(_buckets), 0);
+}
+
+double LatencyHistogram::bucketLimit(int bucket)
+{
+    return FirstBucketLimit * (double)(1 << bucket);
+}
+
+void LatencyHistogram::add(double seconds)
+{
+    int bucket = 0;
+
+    while(bucket < BucketCount - 1 && seconds > bucketLimit(bucket))
+        ++bucket;
+
+    ++_buckets[bucket];
+    ++_count;
+}
+
+double LatencyHistogram::percentile(double p) const
+{
+    if(_count == 0)
+        return 0;
+
+    uint32_t rank = (uint32_t)ceil(p * (double)_count);
+    rank = max(rank, 1u);
+
+    uint32_t seen = 0;
+
+    for(int i = 0; i < BucketCount; ++i)
+    {
+        seen += _buckets[i];
+        if(seen >= rank)
+            return bucketLimit(i);
+    }
+
+    return bucketLimit(BucketCount - 1);
+}
+
+uint32_t LatencyHistogram::count() const
+{
+    return _count;
+}
+
+void LatencyHistogram::decay()
+{
+    _count = 0;
+
+    for(auto& bucket : _buckets)
+    {
+        bucket /= 2;
+        _count += bucket;
+    }
+}
+
+////////////////
+// ResponsivenessTracker
+
+ResponsivenessTracker::ResponsivenessTracker()
+    : ResponsivenessTracker([]{
+        auto t = chrono::steady_clock::now().time_since_epoch();
+        return chrono::duration<double>(t).count();
+    })
+{
+
+}
+
+ResponsivenessTracker::ResponsivenessTracker(Clock clock)
+    : _clock(move(clock))
+{
+
+}
+
+double ResponsivenessTracker::now() const
+{
+    return _clock();
+}
+
+bool ResponsivenessTracker::shouldQuery(pid_t pid)
+{
+    auto it = _entries.find(pid);
+    if(it == _entries.end())
+        return true;
+
+    Entry& entry = it->second;
+
+    if(entry.state != Health::Unresponsive)
+        return true;
+
+    if(now() >= entry.nextProbe)
+    {
+        entry.state = Health::Probing;
+        return true;
+    }
+
+    // each skipped query would have cost at least one full timeout
+    ++entry.skipped;
+    entry.timeSaved += _timeoutFor(entry);
+
+    return false;
+}
+
+void ResponsivenessTracker::record(pid_t pid, double latency, Outcome outcome)
+{
+    Entry& entry = _entries[pid];
+    ++entry.samples;
+
+    if(outcome == Outcome::Timeout)
+    {
+        // A timed out query only measured the timeout itself, so it is kept out
+        // of the histogram. Otherwise each timeout would stretch the next one.
+        ++entry.timeouts;
+        ++entry.consecutiveTimeouts;
+
+        if(entry.state == Health::Probing)
+        {
+            entry.probeInterval = min(entry.probeInterval * 2.0, MaxProbeInterval);
+            _open(entry);
+        }
+        else if(entry.state != Health::Unresponsive && entry.consecutiveTimeouts >= FailureThreshold)
+        {
+            entry.probeInterval = MinProbeInterval;
+            _open(entry);
+        }
+    }
+    else
+    {
+        if(outcome == Outcome::Failure)
+            ++entry.failures;
+
+        if(entry.latency.count() >= DecayThreshold)
+            entry.latency.decay();
+
+        entry.latency.add(latency);
+
+        // any reply, even an error, means the app is responding
+        entry.consecutiveTimeouts = 0;
+        entry.probeInterval = MinProbeInterval;
+
+        double p99 = entry.latency.percentile(0.99);
+        entry.state = (p99 > DegradedLatency) ? Health::Degraded : Health::Healthy;
+    }
+}
+
+void ResponsivenessTracker::_open(Entry &entry)
+{
+    entry.state = Health::Unresponsive;
+    entry.nextProbe = now() + entry.probeInterval;
+}
+
+float ResponsivenessTracker::_timeoutFor(const Entry &entry)
+{
+    if(entry.latency.count() < MinSamples)
+        return AX_DEFAULT_TIMEOUT;
+
+    double timeout = entry.latency.percentile(0.99) * TimeoutScale;
+    timeout = min(max(timeout, (double)AX_MIN_TIMEOUT), (double)AX_MAX_TIMEOUT);
+
+    // an app that is timing out gets no more time than an unknown one
+    if(entry.consecutiveTimeouts > 0)
+        timeout = min(timeout, (double)AX_DEFAULT_TIMEOUT);
+
+    return (float)timeout;
+}
+
+float ResponsivenessTracker::timeoutFor(pid_t pid) const
+{
+    auto it = _entries.find(pid);
+    return it != _entries.end() ? _timeoutFor(it->second) : AX_DEFAULT_TIMEOUT;
+}
+
+Health ResponsivenessTracker::state(pid_t pid) const
+{
+    auto it = _entries.find(pid);
+    return it != _entries.end() ? it->second.state : Health::Healthy;
+}
+
+AppHealth ResponsivenessTracker::_snapshot(const Entry &entry)
+{
+    AppHealth ret;
+    ret.state = entry.state;
+    ret.timeout = _timeoutFor(entry);
+    ret.p50 = entry.latency.percentile(0.5);
+    ret.p99 = entry.latency.percentile(0.99);
+    ret.samples = entry.samples;
+    ret.failures = entry.failures;
+    ret.timeouts = entry.timeouts;
+    ret.skipped = entry.skipped;
+    ret.timeSaved = entry.timeSaved;
+    return ret;
+}
+
+AppHealth ResponsivenessTracker::health(pid_t pid) const
+{
+    auto it = _entries.find(pid);
+    return it != _entries.end() ? _snapshot(it->second) : AppHealth();
+}
+
+double ResponsivenessTracker::totalTimeSaved() const
+{
+    double ret = 0;
+
+    for(auto& kv : _entries)
+        ret += kv.second.timeSaved;
+
+    return ret;
+}
+
+void ResponsivenessTracker::remove(pid_t pid)
+{
+    _entries.erase(pid);
+}
+
+void ResponsivenessTracker::clear()
+{
+    _entries.clear();
+}
+
+void ResponsivenessTracker::forEach(const function<void(pid_t, const AppHealth&)> &fn) const
+{
+    for(auto& kv : _entries)
+        fn(kv.first, _snapshot(kv.second));
+}
+
+}
@@ -0,0 +1,159 @@
+/*---------------------------------------------------------------------------------------------
+ *  Copyright (c) Nicolas Jinchereau. All rights reserved.
+ *  Licensed under the MIT License. See License.txt in the project root for license information.
+ *--------------------------------------------------------------------------------------------*/
+
+#pragma once
+#include <sys/types.h>
+#include <cstdint>
+#include <string>
+#include <functional>
+#include <unordered_map>
+using namespace std;
+
+namespace ax
+{
+
+// messaging timeout used until enough samples have been collected for an app
+constexpr float AX_DEFAULT_TIMEOUT = 0.1f;
+constexpr float AX_MIN_TIMEOUT = 0.05f;
+constexpr float AX_MAX_TIMEOUT = 0.5f;
+
+enum class Health
+{
+    // The app answers AX queries within the expected latency.
+    Healthy = 0,
+
+    // The app answers, but slowly. Its timeout is stretched to match.
+    Degraded = 1,
+
+    // The circuit is open: the app timed out repeatedly and is not queried until the next probe.
+    Unresponsive = 2,
+
+    // A single probe is in flight. Success closes the circuit, a timeout re-opens it.
+    Probing = 3
+};
+
+std::string to_string(Health health);
+
+enum class Outcome
+{
+    // the app replied (including "no value" or "unsupported" replies)
+    Success = 0,
+
+    // the app replied with an error
+    Failure = 1,
+
+    // the app did not reply before the messaging timeout expired
+    Timeout = 2
+};
+
+// Log2 latency histogram. Bucket 'i' holds samples up to (0.5ms * 2^i).
+class LatencyHistogram
+{
+public:
+    static constexpr int BucketCount = 16;
+    static constexpr double FirstBucketLimit = 0.0005;
+
+    LatencyHistogram();
+
+    void add(double seconds);
+    double percentile(double p) const;
+    uint32_t count() const;
+
+    // halves all buckets, so that old samples fade out
+    void decay();
+
+    static double bucketLimit(int bucket);
+
+private:
+    uint32_t _buckets[BucketCount];
+    uint32_t _count;
+};
+
+// A snapshot of the state kept for one application.
+struct AppHealth
+{
+    Health state = Health::Healthy;
+    float timeout = AX_DEFAULT_TIMEOUT;
+    double p50 = 0;
+    double p99 = 0;
+    uint32_t samples = 0;
+    uint32_t failures = 0;
+    uint32_t timeouts = 0;
+    uint32_t skipped = 0;
+    double timeSaved = 0;
+};
+
+// Tracks AX latency and errors per process and decides, per process,
+// what messaging timeout to use and whether it should be queried at all.
+class ResponsivenessTracker
+{
+public:
+    typedef function<double()> Clock;
+
+    // consecutive timeouts before the circuit opens
+    static constexpr int FailureThreshold = 3;
+
+    // replies required before the timeout adapts
+    static constexpr uint32_t MinSamples = 8;
+
+    // Timeout = p99 * TimeoutScale, clamped to [AX_MIN_TIMEOUT, AX_MAX_TIMEOUT].
+    // The p99 is a bucket limit, which already rounds the latency up by as much as 2x.
+    // Only replies are sampled, so timeouts never stretch the timeout.
+    static constexpr double TimeoutScale = 2.0;
+
+    // p99 above which an app is reported as Degraded
+    static constexpr double DegradedLatency = 0.05;
+
+    static constexpr double MinProbeInterval = 2.0;
+    static constexpr double MaxProbeInterval = 30.0;
+
+    // the histogram decays once it holds this many samples
+    static constexpr uint32_t DecayThreshold = 256;
+
+    ResponsivenessTracker();
+    explicit ResponsivenessTracker(Clock clock);
+
+    double now() const;
+
+    // Returns false while the circuit for 'pid' is open. The first call after
+    // the probe interval has elapsed returns true and moves the app to Probing.
+    bool shouldQuery(pid_t pid);
+
+    void record(pid_t pid, double latency, Outcome outcome);
+
+    float timeoutFor(pid_t pid) const;
+    Health state(pid_t pid) const;
+    AppHealth health(pid_t pid) const;
+    double totalTimeSaved() const;
+
+    void remove(pid_t pid);
+    void clear();
+
+    void forEach(const function<void(pid_t, const AppHealth&)> &fn) const;
+
+private:
+    struct Entry
+    {
+        Health state = Health::Healthy;
+        LatencyHistogram latency;
+        uint32_t samples = 0;
+        uint32_t failures = 0;
+        uint32_t timeouts = 0;
+        uint32_t skipped = 0;
+        int consecutiveTimeouts = 0;
+        double probeInterval = MinProbeInterval;
+        double nextProbe = 0;
+        double timeSaved = 0;
+    };
+
+    static float _timeoutFor(const Entry &entry);
+    static AppHealth _snapshot(const Entry &entry);
+    void _open(Entry &entry);
+
+    Clock _clock;
+    unordered_map<pid_t, Entry> _entries;
+};
+
+}
@@ -0,0 +1,311 @@
+/*---------------------------------------------------------------------------------------------
+ *  Copyright (c) Nicolas Jinchereau. All rights reserved.
+ *  Licensed under the MIT License. See License.txt in the project root for license information.
+ *--------------------------------------------------------------------------------------------*/
+
+#include <ax/Snapshot.h>
+#include <algorithm>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace ax
+{
+
+constexpr uint32_t Snapshot::Magic;
+constexpr uint16_t Snapshot::Version;
+constexpr size_t Snapshot::HeaderSize;
+
+static const uint8_t FLAG_FOCUSED = 0x01;
+
+uint32_t crc32(const uint8_t *data, size_t size)
+{
+    static uint32_t table[256];
+    static bool initialized = false;
+    
+    if(!initialized)
+    {
+        for(uint32_t i = 0; i < 256; ++i)
+        {
+            uint32_t c = i;
+            for(int k = 0; k < 8; ++k)
+                c = (c & 1) ? (0xEDB88320 ^ (c >> 1)) : (c >> 1);
+            table[i] = c;
+        }
+        
+        initialized = true;
+    }
+    
+    uint32_t crc = 0xFFFFFFFF;
+    
+    for(size_t i = 0; i < size; ++i)
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    
+    return crc ^ 0xFFFFFFFF;
+}
+
+////////////////
+// SnapshotEntry
+
+bool SnapshotEntry::operator==(const SnapshotEntry& other) const
+{
+    return bundleID == other.bundleID
+        && title == other.title
+        && iconPath == other.iconPath
+        && focused == other.focused;
+}
+
+bool SnapshotEntry::operator!=(const SnapshotEntry& other) const
+{
+    return !(*this == other);
+}
+
+////////////////
+// Snapshot
+
+bool Snapshot::operator==(const Snapshot& other) const
+{
+    return entries == other.entries;
+}
+
+bool Snapshot::operator!=(const Snapshot& other) const
+{
+    return !(*this == other);
+}
+
+static void put16(vector<uint8_t>& out, uint16_t value)
+{
+    out.push_back((uint8_t)(value & 0xFF));
+    out.push_back((uint8_t)(value >> 8));
+}
+
+static void put32(vector<uint8_t>& out, uint32_t value)
+{
+    for(int i = 0; i < 4; ++i)
+        out.push_back((uint8_t)(value >> (i * 8)));
+}
+
+static void putString(vector<uint8_t>& out, const string& str)
+{
+    // strings longer than 64K are cut, which can only happen for absurd titles
+    size_t length = min(str.size(), (size_t)0xFFFF);
+    put16(out, (uint16_t)length);
+    out.insert(out.end(), str.begin(), str.begin() + length);
+}
+
+static uint16_t get16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static bool getString(const uint8_t *&p, const uint8_t *end, string& out)
+{
+    if(end - p < 2)
+        return false;
+    
+    uint16_t length = get16(p);
+    p += 2;
+    
+    if(end - p < length)
+        return false;
+    
+    out.assign((const char*)p, length);
+    p += length;
+    
+    return true;
+}
+
+vector<uint8_t> Snapshot::serialize() const
+{
+    vector<uint8_t> payload;
+    
+    for(auto& entry : entries)
+    {
+        payload.push_back(entry.focused ? FLAG_FOCUSED : 0);
+        putString(payload, entry.bundleID);
+        putString(payload, entry.title);
+        putString(payload, entry.iconPath);
+    }
+    
+    vector<uint8_t> ret;
+    ret.reserve(HeaderSize + payload.size());
+    
+    put32(ret, Magic);
+    put16(ret, Version);
+    put16(ret, 0);
+    put32(ret, (uint32_t)entries.size());
+    put32(ret, (uint32_t)payload.size());
+    put32(ret, crc32(payload.data(), payload.size()));
+    
+    ret.insert(ret.end(), payload.begin(), payload.end());
+    
+    return ret;
+}
+
+bool Snapshot::deserialize(const uint8_t *data, size_t size, Snapshot& out)
+{
+    if(size < HeaderSize)
+        return false;
+    
+    if(get32(data) != Magic || get16(data + 4) != Version || get16(data + 6) != 0)
+        return false;
+    
+    uint32_t count = get32(data + 8);
+    uint32_t payloadSize = get32(data + 12);
+    uint32_t checksum = get32(data + 16);
+    
+    if(size - HeaderSize != payloadSize)
+        return false;
+    
+    const uint8_t *p = data + HeaderSize;
+    const uint8_t *end = p + payloadSize;
+    
+    if(crc32(p, payloadSize) != checksum)
+        return false;
+    
+    // each entry takes at least 7 bytes, which bounds 'count' before reserving
+    if(count > payloadSize / 7)
+        return false;
+    
+    vector<SnapshotEntry> entries(count);
+    
+    for(auto& entry : entries)
+    {
+        if(p == end)
+            return false;
+        
+        entry.focused = (*p++ & FLAG_FOCUSED) != 0;
+        
+        if(!getString(p, end, entry.bundleID)
+        || !getString(p, end, entry.title)
+        || !getString(p, end, entry.iconPath))
+        {
+            return false;
+        }
+    }
+    
+    if(p != end)
+        return false;
+    
+    out.entries = move(entries);
+    return true;
+}
+
+bool Snapshot::save(const string& path) const
+{
+    vector<uint8_t> data = serialize();
+    string tempPath = path + ".tmp";
+    
+    FILE *file = fopen(tempPath.c_str(), "wb");
+    if(!file)
+        return false;
+    
+    bool ok = fwrite(data.data(), 1, data.size(), file) == data.size();
+    ok = (fclose(file) == 0) && ok;
+    
+    if(!ok || rename(tempPath.c_str(), path.c_str()) != 0)
+    {
+        remove(tempPath.c_str());
+        return false;
+    }
+    
+    return true;
+}
+
+bool Snapshot::load(const string& path, Snapshot& out)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if(fd < 0)
+        return false;
+    
+    struct stat st;
+    if(fstat(fd, &st) != 0 || st.st_size < (off_t)HeaderSize)
+    {
+        close(fd);
+        return false;
+    }
+    
+    size_t size = (size_t)st.st_size;
+    void *data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    
+    if(data == MAP_FAILED)
+        return false;
+    
+    bool ret = deserialize((const uint8_t*)data, size, out);
+    munmap(data, size);
+    
+    return ret;
+}
+
+////////////////
+// SnapshotReconciler
+
+SnapshotReconciler::SnapshotReconciler()
+{
+    
+}
+
+SnapshotReconciler::SnapshotReconciler(const Snapshot& snapshot)
+    : _entries(snapshot.entries),
+      _claimed(snapshot.entries.size(), false)
+{
+    
+}
+
+int SnapshotReconciler::claim(const string& bundleID, const string& title)
+{
+    int sameApp = -1;
+    
+    for(size_t i = 0; i < _entries.size(); ++i)
+    {
+        if(_claimed[i] || _entries[i].bundleID != bundleID)
+            continue;
+        
+        if(_entries[i].title == title)
+        {
+            _claimed[i] = true;
+            return (int)i;
+        }
+        
+        if(sameApp < 0)
+            sameApp = (int)i;
+    }
+    
+    if(sameApp >= 0)
+        _claimed[sameApp] = true;
+    
+    return sameApp;
+}
+
+bool SnapshotReconciler::isClaimed(size_t index) const
+{
+    return index < _claimed.size() && _claimed[index];
+}
+
+vector<size_t> SnapshotReconciler::unclaimed() const
+{
+    vector<size_t> ret;
+    
+    for(size_t i = 0; i < _claimed.size(); ++i)
+    {
+        if(!_claimed[i])
+            ret.push_back(i);
+    }
+    
+    return ret;
+}
+
+size_t SnapshotReconciler::size() const
+{
+    return _entries.size();
+}
+
+}
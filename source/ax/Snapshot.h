@@ -0,0 +1,89 @@
+/*---------------------------------------------------------------------------------------------
+ *  Copyright (c) Nicolas Jinchereau. All rights reserved.
+ *  Licensed under the MIT License. See License.txt in the project root for license information.
+ *--------------------------------------------------------------------------------------------*/
+
+#pragma once
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+using namespace std;
+
+namespace ax
+{
+
+// One taskbar button, in taskbar order.
+struct SnapshotEntry
+{
+    string bundleID;
+    string title;
+    
+    // path of a pre-rasterized icon, or empty if there is none
+    string iconPath;
+    
+    bool focused = false;
+    
+    bool operator==(const SnapshotEntry& other) const;
+    bool operator!=(const SnapshotEntry& other) const;
+};
+
+// The last known taskbar layout, saved so that it can be painted
+// immediately on the next launch, before applications are enumerated.
+//
+// File layout (little endian):
+//   uint32 magic, uint16 version, uint16 reserved,
+//   uint32 entry count, uint32 payload size, uint32 payload crc32,
+//   payload: per entry, uint8 flags followed by bundleID, title and iconPath,
+//            each as a uint16 byte length and UTF-8 bytes.
+class Snapshot
+{
+public:
+    static constexpr uint32_t Magic = 0x53534254; // "TBSS"
+    static constexpr uint16_t Version = 1;
+    static constexpr size_t HeaderSize = 20;
+    
+    vector<SnapshotEntry> entries;
+    
+    bool operator==(const Snapshot& other) const;
+    bool operator!=(const Snapshot& other) const;
+    
+    vector<uint8_t> serialize() const;
+    
+    // returns false if the data is truncated, corrupt, or from another version
+    static bool deserialize(const uint8_t *data, size_t size, Snapshot& out);
+    
+    // writes to a temporary file, then renames it over 'path'
+    bool save(const string& path) const;
+    
+    // reads 'path' through a read-only memory mapping
+    static bool load(const string& path, Snapshot& out);
+};
+
+uint32_t crc32(const uint8_t *data, size_t size);
+
+// Matches live windows to snapshot entries as they are discovered, so
+// that the buttons painted from the snapshot can be reused in place.
+class SnapshotReconciler
+{
+public:
+    SnapshotReconciler();
+    explicit SnapshotReconciler(const Snapshot& snapshot);
+    
+    // Returns the index of the unclaimed entry that best matches the window,
+    // preferring an exact title match within the same app, or -1 if there is none.
+    int claim(const string& bundleID, const string& title);
+    
+    bool isClaimed(size_t index) const;
+    
+    // entries that were never claimed by a live window
+    vector<size_t> unclaimed() const;
+    
+    size_t size() const;
+
+private:
+    vector<SnapshotEntry> _entries;
+    vector<bool> _claimed;
+};
+
+}
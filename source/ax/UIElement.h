@@ -15,10 +15,13 @@ using namespace std;
 
 namespace ax
 {
+
+class ResponsivenessTracker;
+
 class UIElement
 {
     AXUIElementRef _element_ref;
-    
+
 public:
     friend class Observer;
     friend class Attribute;
@@ -46,20 +49,25 @@ public:
     
     static UIElement systemWideElement();
     
+    // Queries made through any UIElement are timed and reported to 'tracker',
+    // and are skipped while the tracker considers the target process unresponsive.
+    static void setResponsivenessTracker(ResponsivenessTracker *tracker);
+    
     bool isValid() const;
     size_t hashCode() const;
     size_t childCount();
     UIElement childAt(size_t index);
     vector<UIElement> children();
     AXUIElementRef elementRef();
-    Attribute attributeFor(CFStringRef name);
+    // 'error' receives the AX error, which is kAXErrorCannotComplete if the app wasn't queried
+    Attribute attributeFor(CFStringRef name, AXError *error = nullptr);
     AXError setAttribute(CFStringRef name, const Attribute &att);
     bool isAttributeSettable(CFStringRef name);
     int hasAttribute(CFStringRef name);
     AXError performAction(CFStringRef name);
     AXError setMessagingTimeout(float seconds);
 };
-    
+
 inline UIElement::operator bool() const {
     return _element_ref != nullptr;
 }
@@ -4,11 +4,73 @@
  *--------------------------------------------------------------------------------------------*/
 
 #include <ax/UIElement.h>
+#include <ax/Responsiveness.h>
 #include <iostream>
 
 namespace ax
 {
 
+static ResponsivenessTracker *_tracker = nullptr;
+
+namespace
+{
+
+// Times a single AX query and reports it to the responsiveness tracker.
+class Query
+{
+    pid_t _pid;
+    double _start;
+    bool _allowed;
+
+public:
+    explicit Query(AXUIElementRef elementRef)
+        : _pid(0), _start(0), _allowed(true)
+    {
+        if(_tracker && elementRef && AXUIElementGetPid(elementRef, &_pid) == kAXErrorSuccess)
+        {
+            _allowed = _tracker->shouldQuery(_pid);
+            _start = _tracker->now();
+        }
+        else
+        {
+            _pid = 0;
+        }
+    }
+    
+    bool allowed() const {
+        return _allowed;
+    }
+    
+    void finish(AXError err)
+    {
+        if(!_tracker || _pid == 0)
+            return;
+        
+        Outcome outcome = Outcome::Failure;
+        
+        if(err == kAXErrorSuccess
+        || err == kAXErrorNoValue
+        || err == kAXErrorAttributeUnsupported
+        || err == kAXErrorParameterizedAttributeUnsupported)
+        {
+            outcome = Outcome::Success;
+        }
+        else if(err == kAXErrorCannotComplete)
+        {
+            outcome = Outcome::Timeout;
+        }
+        
+        _tracker->record(_pid, _tracker->now() - _start, outcome);
+    }
+};
+
+}
+
+void UIElement::setResponsivenessTracker(ResponsivenessTracker *tracker)
+{
+    _tracker = tracker;
+}
+
 UIElement::UIElement()
     : _element_ref(NULL)
 {
@@ -79,11 +141,17 @@ UIElement UIElement::systemWideElement()
 
 bool UIElement::isValid() const
 {
+    // an unresponsive app is still a valid one
+    Query query(_element_ref);
+    if(!query.allowed())
+        return true;
+    
     CFIndex childCount;
     AXError err = AXUIElementGetAttributeValueCount(_element_ref, kAXChildrenAttribute, &childCount);
+    query.finish(err);
     return err != kAXErrorInvalidUIElement;
 }
-    
+
 size_t UIElement::hashCode() const
 {
     return CFHash(_element_ref);
@@ -91,17 +159,27 @@ size_t UIElement::hashCode() const
 
 size_t UIElement::childCount()
 {
-    CFIndex childCount;
-    AXUIElementGetAttributeValueCount(_element_ref, kAXChildrenAttribute, &childCount);
+    Query query(_element_ref);
+    if(!query.allowed())
+        return 0;
+    
+    CFIndex childCount = 0;
+    AXError err = AXUIElementGetAttributeValueCount(_element_ref, kAXChildrenAttribute, &childCount);
+    query.finish(err);
     return (size_t)childCount;
 }
 
 UIElement UIElement::childAt(size_t index)
 {
+    UIElement ret;
+    
+    Query query(_element_ref);
+    if(!query.allowed())
+        return ret;
+    
     CFArrayRef child;
     AXError err = AXUIElementCopyAttributeValues(_element_ref, kAXChildrenAttribute, index, 1, &child);
-    
-    UIElement ret;
+    query.finish(err);
     
     if(err == 0)
     {
@@ -116,8 +194,13 @@ vector<UIElement> UIElement::children()
 {
     vector<UIElement> ret;
     
+    Query query(_element_ref);
+    if(!query.allowed())
+        throw runtime_error("failed to retrieve children: application is unresponsive");
+    
     CFIndex childCount = 0;
     AXError err = AXUIElementGetAttributeValueCount(_element_ref, kAXChildrenAttribute, &childCount);
+    query.finish(err);
     
     if(err)
         throw runtime_error("failed to retrieve children: "s + to_string(err));
@@ -145,13 +228,24 @@ AXUIElementRef UIElement::elementRef()
 {
     return _element_ref;
 }
-    
-Attribute UIElement::attributeFor(CFStringRef name)
+
+Attribute UIElement::attributeFor(CFStringRef name, AXError *error)
 {
     Attribute ret;
     
+    if(error)
+        *error = kAXErrorCannotComplete;
+    
+    Query query(_element_ref);
+    if(!query.allowed())
+        return ret;
+    
     CFTypeRef value;
     AXError err = AXUIElementCopyAttributeValue(_element_ref, name, &value);
+    query.finish(err);
+    
+    if(error)
+        *error = err;
     
     if(err)
     {
@@ -180,8 +274,13 @@ AXError UIElement::setAttribute(CFStringRef name, const Attribute &att)
 
 int UIElement::hasAttribute(CFStringRef name)
 {
+    Query query(_element_ref);
+    if(!query.allowed())
+        return -1;
+    
     CFTypeRef value;
     AXError err = AXUIElementCopyAttributeValue(_element_ref, name, &value);
+    query.finish(err);
     
     if(err == kAXErrorSuccess)
     {
@@ -58,10 +58,10 @@ private:
     
     void createWindow();
     void destroyWindow();
+    void unsubscribe();
     
     Application *_app;
     UIElement _element;
-    Observer _observer;
     string _title;
     State _state;
     bool _dirty;
@@ -20,7 +20,8 @@ Window::Window(Application *app, const UIElement& element)
       _dirty(false),
       _hasWindow(false)
 {
-    
+    if(app->_timeout > 0)
+        _element.setMessagingTimeout(app->_timeout);
 }
 
 Window::Window(Window &&other)
@@ -28,7 +29,6 @@ Window::Window(Window &&other)
     _app = other._app;
     _element = move(other._element);
     _title = move(other._title);
-    _observer = move(other._observer);
     _state = other._state;
     _dirty = other._dirty;
     _hasWindow = other._hasWindow;
@@ -37,6 +37,9 @@ Window::Window(Window &&other)
     other._state = State::Pending;
     other._dirty = false;
     other._hasWindow = false;
+    
+    if(_app && _app->_observer.target(_element) == &other)
+        _app->_observer._targets[_element] = this;
 }
 
 Window::~Window()
@@ -44,6 +47,8 @@ Window::~Window()
     //cout << "~Window destroyed: " << this->title() << endl;
     if(_hasWindow)
         this->destroyWindow();
+    
+    unsubscribe();
 }
 
 Window& Window::operator=(Window &&other)
@@ -51,7 +56,6 @@ Window& Window::operator=(Window &&other)
     _app = other._app;
     _element = move(other._element);
     _title = move(other._title);
-    _observer = move(other._observer);
     _state = other._state;
     _dirty = other._dirty;
     _hasWindow = other._hasWindow;
@@ -61,6 +65,9 @@ Window& Window::operator=(Window &&other)
     other._dirty = false;
     other._hasWindow = false;
     
+    if(_app && _app->_observer.target(_element) == &other)
+        _app->_observer._targets[_element] = this;
+    
     return *this;
 }
 
@@ -151,30 +158,26 @@ int Window::update()
             if(!attTitle)
                 throw runtime_error("failed to retrieve window title: " + _title);
             
-            Observer obs(_app);
+            Observer& obs = _app->_observer;
             
-            if(!obs.addNotification(_element, kAXUIElementDestroyedNotification))
+            if(!obs.addNotification(_element, kAXUIElementDestroyedNotification, this))
                 throw std::runtime_error("error adding kAXUIElementDestroyedNotification: " + _title);
             
-            if(!obs.addNotification(_element, kAXTitleChangedNotification))
+            if(!obs.addNotification(_element, kAXTitleChangedNotification, this))
                 throw std::runtime_error("error adding kAXTitleChangedNotification: " + _title);
             
             string newTitle = attTitle.stringValue();
             if(!newTitle.empty())
                 _title =  attTitle.stringValue();
             
-            _observer = move(obs);
             _state = State::Valid;
             
             _dirty = false;
             
             if(!_app->_hidden)
-            {
                 createWindow();
-                
-                if(_app->runningApplication().active)
-                    [_app->_workspace focusWindow:this focused:true];
-            }
+            
+            [_app->_workspace windowAdded:this];
         }
         catch(window_type_error& ex)
         {
@@ -184,6 +187,7 @@ int Window::update()
         catch(runtime_error& ex)
         {
             cout << ex.what() << endl;
+            unsubscribe();
             ++errors;
         }
     }
@@ -305,5 +309,11 @@ void Window::destroyWindow()
     _hasWindow = false;
     [_app->_workspace windowDestroyed:this];
 }
+
+void Window::unsubscribe()
+{
+    if(_app && _app->_observer.target(_element) == this)
+        _app->_observer.removeNotifications(_element);
+}
     
 }
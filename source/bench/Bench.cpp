@@ -0,0 +1,253 @@
+/*---------------------------------------------------------------------------------------------
+ *  Copyright (c) Nicolas Jinchereau. All rights reserved.
+ *  Licensed under the MIT License. See License.txt in the project root for license information.
+ *--------------------------------------------------------------------------------------------*/
+
+#include <bench/Bench.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <new>
+#include <sstream>
+#include <sys/resource.h>
+
+////////////////
+// allocation counting
+
+static std::atomic<uint64_t> _allocations(0);
+
+void* operator new(size_t size)
+{
+    _allocations.fetch_add(1, std::memory_order_relaxed);
+    
+    if(void *p = malloc(size ? size : 1))
+        return p;
+    
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    _allocations.fetch_add(1, std::memory_order_relaxed);
+    return malloc(size ? size : 1);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return operator new(size, std::nothrow);
+}
+
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void *p, size_t) noexcept
+{
+    free(p);
+}
+
+namespace bench
+{
+
+uint64_t allocationCount()
+{
+    return _allocations.load(std::memory_order_relaxed);
+}
+
+uint64_t peakRSS()
+{
+    struct rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+
+#if defined(__APPLE__)
+    return (uint64_t)usage.ru_maxrss / 1024; // bytes
+#else
+    return (uint64_t)usage.ru_maxrss; // kilobytes
+#endif
+}
+
+////////////////
+// Recorder
+
+Recorder::Recorder(size_t expectedEvents)
+    : _totalTime(0), _allocations(0), _sorted(true)
+{
+    _samples.reserve(expectedEvents);
+}
+
+void Recorder::add(double seconds)
+{
+    _samples.push_back(seconds);
+    _totalTime += seconds;
+    _sorted = false;
+}
+
+size_t Recorder::events() const
+{
+    return _samples.size();
+}
+
+double Recorder::totalTime() const
+{
+    return _totalTime;
+}
+
+uint64_t Recorder::allocations() const
+{
+    return _allocations;
+}
+
+void Recorder::_sort()
+{
+    if(!_sorted)
+    {
+        sort(_samples.begin(), _samples.end());
+        _sorted = true;
+    }
+}
+
+double Recorder::percentile(double p)
+{
+    if(_samples.empty())
+        return 0;
+    
+    _sort();
+    
+    // nearest rank
+    size_t rank = (size_t)ceil(p * (double)_samples.size());
+    rank = std::min(std::max(rank, (size_t)1), _samples.size());
+    
+    return _samples[rank - 1];
+}
+
+double Recorder::max()
+{
+    if(_samples.empty())
+        return 0;
+    
+    _sort();
+    return _samples.back();
+}
+
+////////////////
+// Result
+
+void Result::setParam(const string &key, double value)
+{
+    params.emplace_back(key, value);
+}
+
+void Result::setExtra(const string &key, double value)
+{
+    extra.emplace_back(key, value);
+}
+
+void Result::summarize(Recorder &recorder)
+{
+    events = recorder.events();
+    seconds = recorder.totalTime();
+    throughput = seconds > 0 ? (double)events / seconds : 0;
+    p50 = recorder.percentile(0.5);
+    p99 = recorder.percentile(0.99);
+    p999 = recorder.percentile(0.999);
+    max = recorder.max();
+    allocationsPerEvent = events ? (double)recorder.allocations() / (double)events : 0;
+    peakRSS = bench::peakRSS();
+}
+
+static string number(double value)
+{
+    if(!isfinite(value))
+        return "null";
+    
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "%.6g", value);
+    return buffer;
+}
+
+static void writeObject(ostringstream &out, const vector<pair<string, double>> &values)
+{
+    out << "{";
+    
+    for(size_t i = 0; i < values.size(); ++i)
+    {
+        if(i)
+            out << ", ";
+        
+        out << "\"" << values[i].first << "\": " << number(values[i].second);
+    }
+    
+    out << "}";
+}
+
+string Result::toJSON(int indent) const
+{
+    string pad(indent, ' ');
+    string pad2(indent + 2, ' ');
+    
+    ostringstream out;
+    out << pad << "{\n";
+    out << pad2 << "\"name\": \"" << name << "\",\n";
+    out << pad2 << "\"params\": ";
+    writeObject(out, params);
+    out << ",\n";
+    out << pad2 << "\"events\": " << events << ",\n";
+    out << pad2 << "\"seconds\": " << number(seconds) << ",\n";
+    out << pad2 << "\"throughput_per_sec\": " << number(throughput) << ",\n";
+    out << pad2 << "\"latency_us\": ";
+    writeObject(out, {
+        { "p50", p50 * 1e6 },
+        { "p99", p99 * 1e6 },
+        { "p999", p999 * 1e6 },
+        { "max", max * 1e6 }
+    });
+    out << ",\n";
+    out << pad2 << "\"allocations_per_event\": " << number(allocationsPerEvent) << ",\n";
+    out << pad2 << "\"peak_rss_kb\": " << peakRSS << ",\n";
+    out << pad2 << "\"extra\": ";
+    writeObject(out, extra);
+    out << "\n";
+    out << pad << "}";
+    
+    return out.str();
+}
+
+string reportJSON(const vector<string> &scenarios)
+{
+    ostringstream out;
+    out << "{\n";
+    out << "  \"benchmark\": \"taskbar-model\",\n";
+    out << "  \"format\": 2,\n";
+    out << "  \"scenarios\": [\n";
+    
+    for(size_t i = 0; i < scenarios.size(); ++i)
+    {
+        out << scenarios[i];
+        out << (i + 1 < scenarios.size() ? ",\n" : "\n");
+    }
+    
+    out << "  ]\n";
+    out << "}\n";
+    
+    return out.str();
+}
+
+}
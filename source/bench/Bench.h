@@ -0,0 +1,97 @@
+/*---------------------------------------------------------------------------------------------
+ *  Copyright (c) Nicolas Jinchereau. All rights reserved.
+ *  Licensed under the MIT License. See License.txt in the project root for license information.
+ *--------------------------------------------------------------------------------------------*/
+
+#pragma once
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <utility>
+#include <chrono>
+using namespace std;
+
+namespace bench
+{
+
+// heap allocations made through operator new since the process started
+uint64_t allocationCount();
+
+// peak resident set size of the process, in kilobytes
+uint64_t peakRSS();
+
+// Collects the latency of each event in a scenario, along with the
+// allocations made while handling them.
+class Recorder
+{
+public:
+    explicit Recorder(size_t expectedEvents = 0);
+    
+    // times one event, and counts the allocations made by 'fn'
+    template<class F>
+    void measure(F &&fn)
+    {
+        uint64_t allocs = allocationCount();
+        auto start = chrono::steady_clock::now();
+        
+        fn();
+        
+        auto end = chrono::steady_clock::now();
+        _allocations += allocationCount() - allocs;
+        
+        add(chrono::duration<double>(end - start).count());
+    }
+    
+    // adds an event timed by the caller, without counting allocations
+    void add(double seconds);
+    
+    size_t events() const;
+    double totalTime() const;
+    uint64_t allocations() const;
+    
+    // 'p' in [0, 1], in seconds
+    double percentile(double p);
+    double max();
+
+private:
+    void _sort();
+    
+    vector<double> _samples;
+    double _totalTime;
+    uint64_t _allocations;
+    bool _sorted;
+};
+
+// The outcome of one scenario, written out as one JSON object.
+struct Result
+{
+    string name;
+    vector<pair<string, double>> params;
+    vector<pair<string, double>> extra;
+    
+    uint64_t events = 0;
+    double seconds = 0;
+    double throughput = 0;
+    double p50 = 0;
+    double p99 = 0;
+    double p999 = 0;
+    double max = 0;
+    double allocationsPerEvent = 0;
+    
+    // peak RSS of the process the scenario ran in, which runs no other scenario
+    uint64_t peakRSS = 0;
+    
+    void setParam(const string &key, double value);
+    void setExtra(const string &key, double value);
+    
+    // fills in the event, latency and allocation figures from 'recorder'
+    void summarize(Recorder &recorder);
+    
+    string toJSON(int indent) const;
+};
+
+// the report for scenarios already written with Result::toJSON(4)
+string reportJSON(const vector<string> &scenarios);
+
+}
@@ -0,0 +1,291 @@
+/*---------------------------------------------------------------------------------------------
+ *  Copyright (c) Nicolas Jinchereau. All rights reserved.
+ *  Licensed under the MIT License. See License.txt in the project root for license information.
+ *--------------------------------------------------------------------------------------------*/
+
+#include <bench/FakeAX.h>
+#include <algorithm>
+#include <stdexcept>
+
+namespace bench
+{
+
+FakeAX::FakeAX(uint32_t seed)
+    : _random(seed),
+      _nextPID(100),
+      _nextElement(1),
+      _frontmost(0),
+      _now(0),
+      _lastLatency(0),
+      _queries(0)
+{
+    
+}
+
+FakeAX::App& FakeAX::_app(pid_t pid)
+{
+    auto it = _apps.find(pid);
+    if(it == _apps.end())
+        throw runtime_error("no such application");
+    
+    return it->second;
+}
+
+const FakeAX::App& FakeAX::_app(pid_t pid) const
+{
+    auto it = _apps.find(pid);
+    if(it == _apps.end())
+        throw runtime_error("no such application");
+    
+    return it->second;
+}
+
+void FakeAX::_post(Notification notification, pid_t pid, ElementID element)
+{
+    _events.push_back(Event{ notification, pid, element });
+}
+
+pid_t FakeAX::launch(const string &bundleID, double latency)
+{
+    pid_t pid = _nextPID++;
+    
+    App &app = _apps[pid];
+    app.bundleID = bundleID;
+    app.latency = latency;
+    
+    return pid;
+}
+
+void FakeAX::terminate(pid_t pid)
+{
+    _apps.erase(pid);
+    
+    if(_frontmost == pid)
+        _frontmost = 0;
+    
+    // notifications from a dead app are never delivered
+    _events.erase(remove_if(_events.begin(), _events.end(),
+                            [pid](const Event &e){ return e.pid == pid; }),
+                  _events.end());
+}
+
+ElementID FakeAX::createWindow(pid_t pid, const string &title)
+{
+    App &app = _app(pid);
+    
+    ElementID window = _nextElement++;
+    app.windows.push_back(window);
+    app.titles[window] = title;
+    
+    _post(Notification::WindowCreated, pid, window);
+    
+    if(!app.main)
+    {
+        app.main = window;
+        _post(Notification::MainWindowChanged, pid, window);
+    }
+    
+    return window;
+}
+
+void FakeAX::destroyWindow(pid_t pid, ElementID window)
+{
+    App &app = _app(pid);
+    
+    auto it = find(app.windows.begin(), app.windows.end(), window);
+    if(it == app.windows.end())
+        return;
+    
+    app.windows.erase(it);
+    app.titles.erase(window);
+    
+    _post(Notification::WindowDestroyed, pid, window);
+    
+    if(app.main == window)
+    {
+        app.main = app.windows.empty() ? 0 : app.windows.back();
+        
+        if(app.main)
+            _post(Notification::MainWindowChanged, pid, app.main);
+    }
+}
+
+void FakeAX::setTitle(pid_t pid, ElementID window, const string &title)
+{
+    App &app = _app(pid);
+    
+    auto it = app.titles.find(window);
+    if(it == app.titles.end())
+        return;
+    
+    it->second = title;
+    _post(Notification::TitleChanged, pid, window);
+}
+
+void FakeAX::setMainWindow(pid_t pid, ElementID window)
+{
+    App &app = _app(pid);
+    
+    if(app.main != window && app.titles.count(window))
+    {
+        app.main = window;
+        _post(Notification::MainWindowChanged, pid, window);
+    }
+}
+
+void FakeAX::activate(pid_t pid)
+{
+    if(_frontmost == pid)
+        return;
+    
+    if(_frontmost)
+        _post(Notification::AppDeactivated, _frontmost, 0);
+    
+    _frontmost = pid;
+    _post(Notification::AppActivated, pid, 0);
+}
+
+void FakeAX::setHidden(pid_t pid, bool hidden)
+{
+    App &app = _app(pid);
+    
+    if(app.hidden != hidden)
+    {
+        app.hidden = hidden;
+        _post(hidden ? Notification::AppHidden : Notification::AppShown, pid, 0);
+    }
+}
+
+void FakeAX::setHung(pid_t pid, bool hung)
+{
+    _app(pid).hung = hung;
+}
+
+vector<pid_t> FakeAX::applications() const
+{
+    vector<pid_t> ret;
+    ret.reserve(_apps.size());
+    
+    for(auto &kv : _apps)
+        ret.push_back(kv.first);
+    
+    // launch order, like NSWorkspace.runningApplications
+    sort(ret.begin(), ret.end());
+    return ret;
+}
+
+pid_t FakeAX::frontmost() const
+{
+    return _frontmost;
+}
+
+const vector<ElementID>& FakeAX::windows(pid_t pid) const
+{
+    return _app(pid).windows;
+}
+
+const string& FakeAX::bundleID(pid_t pid) const
+{
+    return _app(pid).bundleID;
+}
+
+bool FakeAX::isHidden(pid_t pid) const
+{
+    return _app(pid).hidden;
+}
+
+bool FakeAX::_reply(App &app, float timeout)
+{
+    ++_queries;
+    
+    if(app.hung)
+    {
+        _lastLatency = timeout;
+        _now += timeout;
+        return false;
+    }
+    
+    // exponentially distributed around the app's mean latency
+    exponential_distribution<double> dist(1.0 / max(app.latency, 1e-6));
+    double latency = min(dist(_random), (double)timeout);
+    
+    _lastLatency = latency;
+    _now += latency;
+    
+    return latency < timeout;
+}
+
+AXResult FakeAX::copyWindows(pid_t pid, float timeout, vector<ElementID> &out)
+{
+    App &app = _app(pid);
+    
+    if(!_reply(app, timeout))
+        return AXResult::CannotComplete;
+    
+    out = app.windows;
+    return AXResult::Success;
+}
+
+AXResult FakeAX::copyMainWindow(pid_t pid, float timeout, ElementID &out)
+{
+    App &app = _app(pid);
+    
+    if(!_reply(app, timeout))
+        return AXResult::CannotComplete;
+    
+    out = app.main;
+    return app.main ? AXResult::Success : AXResult::NoValue;
+}
+
+AXResult FakeAX::copyTitle(pid_t pid, ElementID window, float timeout, string &out)
+{
+    App &app = _app(pid);
+    
+    if(!_reply(app, timeout))
+        return AXResult::CannotComplete;
+    
+    auto it = app.titles.find(window);
+    if(it == app.titles.end())
+        return AXResult::NoValue;
+    
+    out = it->second;
+    return AXResult::Success;
+}
+
+double FakeAX::now() const
+{
+    return _now;
+}
+
+void FakeAX::advance(double seconds)
+{
+    _now += seconds;
+}
+
+double FakeAX::lastLatency() const
+{
+    return _lastLatency;
+}
+
+uint64_t FakeAX::queries() const
+{
+    return _queries;
+}
+
+bool FakeAX::poll(Event &event)
+{
+    if(_events.empty())
+        return false;
+    
+    event = _events.front();
+    _events.pop_front();
+    
+    return true;
+}
+
+size_t FakeAX::pending() const
+{
+    return _events.size();
+}
+
+}
@@ -0,0 +1,124 @@
+/*---------------------------------------------------------------------------------------------
+ *  Copyright (c) Nicolas Jinchereau. All rights reserved.
+ *  Licensed under the MIT License. See License.txt in the project root for license information.
+ *--------------------------------------------------------------------------------------------*/
+
+#pragma once
+#include <sys/types.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <deque>
+#include <random>
+#include <unordered_map>
+using namespace std;
+
+namespace bench
+{
+
+// stands in for an AXUIElementRef
+typedef uint64_t ElementID;
+
+enum class Notification
+{
+    AppShown,
+    AppHidden,
+    AppActivated,
+    AppDeactivated,
+    WindowCreated,
+    WindowDestroyed,
+    TitleChanged,
+    MainWindowChanged
+};
+
+struct Event
+{
+    Notification notification;
+    pid_t pid;
+    ElementID element;
+};
+
+enum class AXResult
+{
+    Success,
+    NoValue,
+    CannotComplete // the messaging timeout expired
+};
+
+// A simulated accessibility server. It owns the applications and their
+// windows, answers queries with a simulated per-app latency, and queues the
+// notifications an AXObserver would deliver as the apps change.
+//
+// Time is simulated: queries advance the clock by their latency instead of
+// blocking, so scenarios measure the taskbar's own cost, not the apps'.
+class FakeAX
+{
+public:
+    explicit FakeAX(uint32_t seed);
+    
+    // 'latency' is the mean reply time of the app's AX queries, in seconds
+    pid_t launch(const string &bundleID, double latency);
+    void terminate(pid_t pid);
+    
+    ElementID createWindow(pid_t pid, const string &title);
+    void destroyWindow(pid_t pid, ElementID window);
+    void setTitle(pid_t pid, ElementID window, const string &title);
+    void setMainWindow(pid_t pid, ElementID window);
+    void activate(pid_t pid);
+    void setHidden(pid_t pid, bool hidden);
+    
+    // the app stops replying, so every query times out
+    void setHung(pid_t pid, bool hung);
+    
+    vector<pid_t> applications() const;
+    pid_t frontmost() const;
+    const vector<ElementID>& windows(pid_t pid) const;
+    const string& bundleID(pid_t pid) const;
+    bool isHidden(pid_t pid) const;
+    
+    // AXUIElementCopyAttributeValue on an app or window, with 'timeout' as the messaging timeout
+    AXResult copyWindows(pid_t pid, float timeout, vector<ElementID> &out);
+    AXResult copyMainWindow(pid_t pid, float timeout, ElementID &out);
+    AXResult copyTitle(pid_t pid, ElementID window, float timeout, string &out);
+    
+    // simulated seconds since the server started
+    double now() const;
+    void advance(double seconds);
+    
+    // the reply time of the last query
+    double lastLatency() const;
+    uint64_t queries() const;
+    
+    // pops the next notification, in the order the changes were made
+    bool poll(Event &event);
+    size_t pending() const;
+
+private:
+    struct App
+    {
+        string bundleID;
+        double latency = 0;
+        bool hidden = false;
+        bool hung = false;
+        ElementID main = 0;
+        vector<ElementID> windows;
+        unordered_map<ElementID, string> titles;
+    };
+    
+    App& _app(pid_t pid);
+    const App& _app(pid_t pid) const;
+    bool _reply(App &app, float timeout);
+    void _post(Notification notification, pid_t pid, ElementID element);
+    
+    mt19937 _random;
+    unordered_map<pid_t, App> _apps;
+    deque<Event> _events;
+    pid_t _nextPID;
+    ElementID _nextElement;
+    pid_t _frontmost;
+    double _now;
+    double _lastLatency;
+    uint64_t _queries;
+};
+
+}
@@ -0,0 +1,492 @@
+/*---------------------------------------------------------------------------------------------
+ *  Copyright (c) Nicolas Jinchereau. All rights reserved.
+ *  Licensed under the MIT License. See License.txt in the project root for license information.
+ *--------------------------------------------------------------------------------------------*/
+
+#include <bench/Scenarios.h>
+#include <bench/FakeAX.h>
+#include <bench/TaskbarModel.h>
+#include <algorithm>
+#include <cstdio>
+#include <random>
+
+namespace bench
+{
+
+static const float FrameTime = 1.0f / 60.0f;
+
+// retry interval and placeholder timeout of the app, in simulated seconds
+static const double RetryDelay = 1.0;
+static const double PlaceholderTimeout = 5.0;
+
+// frames allowed for an animation to settle, before giving up on it
+static const int MaxSettleFrames = 10000;
+
+static const char *words[] = {
+    "Untitled", "Report", "Inbox", "Terminal", "Quarterly Budget", "notes.txt",
+    "Downloads", "main.cpp", "Project Plan", "Meeting", "Preferences", "Welcome"
+};
+
+static string windowTitle(int app, int window)
+{
+    char buffer[96];
+    snprintf(buffer, sizeof(buffer), "%s %d - App%d",
+             words[(app * 7 + window) % (sizeof(words) / sizeof(words[0]))], window, app);
+    return buffer;
+}
+
+static string bundleID(int app)
+{
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "com.example.app%d", app);
+    return buffer;
+}
+
+// launches apps with windows, makes the first app frontmost, and marks the last 'hungApps' as hung
+static vector<pid_t> populate(FakeAX &ax, const Options &options)
+{
+    vector<pid_t> pids;
+    
+    for(int a = 0; a < options.apps; ++a)
+    {
+        pid_t pid = ax.launch(bundleID(a), options.latency);
+        
+        for(int w = 0; w < options.windows; ++w)
+            ax.createWindow(pid, windowTitle(a, w));
+        
+        pids.push_back(pid);
+    }
+    
+    for(int a = max(options.apps - options.hungApps, 0); a < options.apps; ++a)
+        ax.setHung(pids[a], true);
+    
+    if(!pids.empty())
+        ax.activate(pids.front());
+    
+    // the windows existed before the taskbar started, so nothing was observed
+    Event event;
+    while(ax.poll(event)) {}
+    
+    return pids;
+}
+
+static int settle(TaskbarModel &model, Recorder *frames = nullptr)
+{
+    int count = 0;
+    
+    while(model.isAnimating() && count < MaxSettleFrames)
+    {
+        if(frames)
+            frames->measure([&]{ model.step(FrameTime); });
+        else
+            model.step(FrameTime);
+        
+        ++count;
+    }
+    
+    return count;
+}
+
+static void setCommonParams(Result &result, const Options &options)
+{
+    result.setParam("apps", options.apps);
+    result.setParam("windows", options.windows);
+    result.setParam("latency", options.latency);
+    result.setParam("hung_apps", options.hungApps);
+    result.setParam("bar_width", options.barWidth);
+    result.setParam("seed", options.seed);
+}
+
+static void setModelExtras(Result &result, const TaskbarModel &model)
+{
+    const TaskbarStats &stats = model.stats();
+    
+    result.setExtra("notifications", (double)stats.notifications);
+    result.setExtra("unrouted", (double)stats.unrouted);
+    result.setExtra("frames", (double)stats.frames);
+    result.setExtra("skipped_queries", (double)stats.skippedQueries);
+    result.setExtra("timeouts", (double)stats.timeouts);
+    result.setExtra("retries", (double)stats.retries);
+    
+    const TextFitCache &titles = model.titles();
+    uint64_t lookups = titles.hits() + titles.misses();
+    result.setExtra("title_cache_hit_rate", lookups ? (double)titles.hits() / (double)lookups : 0);
+}
+
+static void setFrameExtras(Result &result, Recorder &frames)
+{
+    result.setExtra("frame_p50_us", frames.percentile(0.5) * 1e6);
+    result.setExtra("frame_p99_us", frames.percentile(0.99) * 1e6);
+    result.setExtra("frame_max_us", frames.max() * 1e6);
+}
+
+////////////////
+// startup
+
+// N apps x M windows enumerated at launch, one event per app. The first
+// iteration starts cold, and each one after it is painted from the snapshot
+// saved by the one before, then reconciled against the live windows.
+Result startup(const Options &options)
+{
+    Result result;
+    result.name = "startup";
+    setCommonParams(result, options);
+    result.setParam("iterations", options.iterations);
+    
+    Recorder recorder((size_t)options.apps * options.iterations);
+    Recorder paint(options.iterations);
+    
+    vector<uint8_t> saved;
+    uint64_t claimed = 0;
+    uint64_t queries = 0;
+    double coldTime = 0;
+    double warmTime = 0;
+    int settleFrames = 0;
+    
+    for(int i = 0; i < options.iterations; ++i)
+    {
+        FakeAX ax(options.seed + i);
+        populate(ax, options);
+        
+        TaskbarModel model(ax, options.barWidth);
+        
+        if(!saved.empty())
+        {
+            paint.measure([&]{
+                ax::Snapshot snapshot;
+                if(ax::Snapshot::deserialize(saved.data(), saved.size(), snapshot))
+                    model.restore(snapshot);
+            });
+        }
+        
+        double before = recorder.totalTime();
+        
+        for(pid_t pid : ax.applications())
+            recorder.measure([&]{ model.addApplication(pid); });
+        
+        recorder.measure([&]{ model.focusFrontmost(); });
+        
+        // like -[AppDelegate dropPlaceholdersWhenSettled]
+        for(double waited = 0; model.needsRetry() && waited < PlaceholderTimeout; waited += RetryDelay)
+        {
+            ax.advance(RetryDelay);
+            recorder.measure([&]{ model.retry(); });
+        }
+        
+        recorder.measure([&]{ model.dropPlaceholders(); });
+        
+        (i == 0 ? coldTime : warmTime) += recorder.totalTime() - before;
+        
+        settleFrames += settle(model);
+        claimed += model.stats().placeholdersClaimed;
+        queries += ax.queries();
+        
+        saved = model.snapshot().serialize();
+    }
+    
+    result.summarize(recorder);
+    result.setExtra("cold_start_ms", coldTime * 1e3);
+    result.setExtra("warm_start_ms", options.iterations > 1 ? warmTime * 1e3 / (options.iterations - 1) : 0);
+    result.setExtra("snapshot_paint_us", paint.events() ? paint.percentile(0.5) * 1e6 : 0);
+    result.setExtra("snapshot_bytes", (double)saved.size());
+    result.setExtra("placeholders_claimed", (double)claimed);
+    result.setExtra("ax_queries_per_iteration", (double)queries / max(options.iterations, 1));
+    result.setExtra("settle_frames_per_iteration", (double)settleFrames / max(options.iterations, 1));
+    
+    return result;
+}
+
+////////////////
+// title storm
+
+// Every window changes its title 'rate' times per second, like a download
+// or build progress readout, while the strip is drawn at 60fps.
+Result titleStorm(const Options &options)
+{
+    Result result;
+    result.name = "title-storm";
+    setCommonParams(result, options);
+    result.setParam("rate", options.rate);
+    result.setParam("duration", options.duration);
+    
+    FakeAX ax(options.seed);
+    vector<pid_t> pids = populate(ax, options);
+    
+    TaskbarModel model(ax, options.barWidth);
+    model.start();
+    settle(model);
+    
+    vector<pair<pid_t, ElementID>> windows;
+    for(pid_t pid : pids)
+    {
+        for(ElementID window : ax.windows(pid))
+            windows.emplace_back(pid, window);
+    }
+    
+    mt19937 random(options.seed);
+    uniform_int_distribution<size_t> pick(0, windows.empty() ? 0 : windows.size() - 1);
+    
+    size_t expected = (size_t)(options.rate * options.duration * windows.size());
+    Recorder recorder(expected);
+    Recorder frames((size_t)(options.duration / FrameTime) + 1);
+    
+    double perFrame = options.rate * windows.size() * FrameTime;
+    double budget = 0;
+    vector<int> progress(windows.size(), 0);
+    
+    for(double t = 0; t < options.duration && !windows.empty(); t += FrameTime)
+    {
+        for(budget += perFrame; budget >= 1.0; budget -= 1.0)
+        {
+            size_t index = pick(random);
+            int percent = progress[index] = (progress[index] + 1) % 101;
+            
+            char title[96];
+            snprintf(title, sizeof(title), "Downloading %d%% - file%zu.zip", percent, index);
+            ax.setTitle(windows[index].first, windows[index].second, title);
+        }
+        
+        Event event;
+        while(ax.poll(event))
+            recorder.measure([&]{ model.dispatch(event); });
+        
+        model.retry();
+        frames.measure([&]{ model.step(FrameTime); });
+        ax.advance(FrameTime);
+    }
+    
+    result.summarize(recorder);
+    setModelExtras(result, model);
+    setFrameExtras(result, frames);
+    result.setExtra("title_changes", (double)model.stats().titleChanges);
+    
+    return result;
+}
+
+////////////////
+// churn
+
+// Windows are created and destroyed at random, keeping the strip around
+// N x M buttons, with a frame drawn every few operations.
+Result churn(const Options &options)
+{
+    Result result;
+    result.name = "churn";
+    setCommonParams(result, options);
+    result.setParam("operations", options.operations);
+    
+    FakeAX ax(options.seed);
+    vector<pid_t> pids = populate(ax, options);
+    
+    TaskbarModel model(ax, options.barWidth);
+    model.start();
+    settle(model);
+    
+    mt19937 random(options.seed);
+    uniform_int_distribution<size_t> pickApp(0, pids.empty() ? 0 : pids.size() - 1);
+    uniform_int_distribution<int> coin(0, 1);
+    
+    Recorder recorder((size_t)options.operations * 3);
+    Recorder frames((size_t)options.operations / 4 + 1);
+    
+    size_t peakButtons = model.buttonCount();
+    int serial = 0;
+    
+    for(int op = 0; op < options.operations && !pids.empty(); ++op)
+    {
+        pid_t pid = pids[pickApp(random)];
+        const vector<ElementID> &windows = ax.windows(pid);
+        
+        if(!windows.empty() && (coin(random) || (int)windows.size() > options.windows * 2))
+        {
+            uniform_int_distribution<size_t> pickWindow(0, windows.size() - 1);
+            ax.destroyWindow(pid, windows[pickWindow(random)]);
+        }
+        else
+        {
+            ax.createWindow(pid, windowTitle((int)pid, ++serial));
+        }
+        
+        Event event;
+        while(ax.poll(event))
+            recorder.measure([&]{ model.dispatch(event); });
+        
+        if(op % 4 == 3)
+        {
+            model.retry();
+            frames.measure([&]{ model.step(FrameTime); });
+            ax.advance(FrameTime);
+            peakButtons = max(peakButtons, model.buttonCount());
+        }
+    }
+    
+    settle(model);
+    
+    result.summarize(recorder);
+    setModelExtras(result, model);
+    setFrameExtras(result, frames);
+    result.setExtra("buttons_added", (double)model.stats().buttonsAdded);
+    result.setExtra("buttons_removed", (double)model.stats().buttonsRemoved);
+    result.setExtra("peak_buttons", (double)peakButtons);
+    result.setExtra("final_windows", (double)model.windowCount());
+    result.setExtra("final_routes", (double)model.routeCount());
+    result.setExtra("final_buttons", (double)model.buttonCount());
+    
+    return result;
+}
+
+////////////////
+// focus ping-pong
+
+// Two apps take turns being frontmost, switching main windows now and then,
+// and occasionally closing the focused window, which leaves focus ambiguous.
+Result focusPingPong(const Options &options)
+{
+    Result result;
+    result.name = "focus-ping-pong";
+    setCommonParams(result, options);
+    result.setParam("switches", options.switches);
+    
+    Options opts = options;
+    opts.apps = max(options.apps, 2);
+    opts.windows = max(options.windows, 1);
+    
+    FakeAX ax(options.seed);
+    vector<pid_t> pids = populate(ax, opts);
+    
+    TaskbarModel model(ax, options.barWidth);
+    model.start();
+    settle(model);
+    
+    mt19937 random(options.seed);
+    Recorder recorder((size_t)options.switches * 3);
+    
+    uint64_t violations = 0;
+    uint64_t queriesBefore = model.focus().queries();
+    uint64_t changesBefore = model.focus().focusChanges();
+    int serial = 0;
+    
+    for(int i = 0; i < options.switches; ++i)
+    {
+        pid_t pid = pids[i % 2];
+        ax.activate(pid);
+        
+        const vector<ElementID> &windows = ax.windows(pid);
+        
+        if(i % 50 == 49 && !windows.empty())
+        {
+            // close the main window, and open a new one in its place
+            ax.destroyWindow(pid, windows.back());
+            ax.createWindow(pid, windowTitle((int)pid, ++serial));
+        }
+        else if(i % 5 == 4 && windows.size() > 1)
+        {
+            uniform_int_distribution<size_t> pickWindow(0, windows.size() - 1);
+            ax.setMainWindow(pid, windows[pickWindow(random)]);
+        }
+        
+        Event event;
+        while(ax.poll(event))
+        {
+            recorder.measure([&]{ model.dispatch(event); });
+            
+            if(!model.focus().checkInvariants().empty())
+                ++violations;
+        }
+        
+        model.retry();
+        ax.advance(FrameTime);
+    }
+    
+    uint64_t queries = model.focus().queries() - queriesBefore;
+    uint64_t changes = model.focus().focusChanges() - changesBefore;
+    
+    result.summarize(recorder);
+    setModelExtras(result, model);
+    result.setExtra("focus_changes", (double)changes);
+    result.setExtra("focus_queries", (double)queries);
+    result.setExtra("ax_queries_per_focus_change", changes ? (double)queries / (double)changes : 0);
+    result.setExtra("invariant_violations", (double)violations);
+    
+    return result;
+}
+
+////////////////
+// animation
+
+// The whole strip of N x M buttons expands in, then collapses out. Each
+// event is one frame of the animation.
+Result animation(const Options &options)
+{
+    Result result;
+    result.name = "animation";
+    setCommonParams(result, options);
+    result.setParam("cycles", options.cycles);
+    
+    FakeAX ax(options.seed);
+    vector<pid_t> pids;
+    
+    for(int a = 0; a < options.apps; ++a)
+        pids.push_back(ax.launch(bundleID(a), options.latency));
+    
+    if(!pids.empty())
+        ax.activate(pids.front());
+    
+    TaskbarModel model(ax, options.barWidth);
+    model.start();
+    model.dispatchAll();
+    
+    Recorder recorder;
+    size_t peakButtons = 0;
+    int incomplete = 0;
+    
+    for(int c = 0; c < options.cycles; ++c)
+    {
+        for(size_t a = 0; a < pids.size(); ++a)
+        {
+            for(int w = 0; w < options.windows; ++w)
+                ax.createWindow(pids[a], windowTitle((int)a, w));
+        }
+        
+        model.dispatchAll();
+        peakButtons = max(peakButtons, model.buttonCount());
+        
+        if(settle(model, &recorder) == MaxSettleFrames)
+            ++incomplete;
+        
+        for(pid_t pid : pids)
+        {
+            vector<ElementID> windows = ax.windows(pid);
+            for(ElementID window : windows)
+                ax.destroyWindow(pid, window);
+        }
+        
+        model.dispatchAll();
+        
+        if(settle(model, &recorder) == MaxSettleFrames)
+            ++incomplete;
+    }
+    
+    result.summarize(recorder);
+    setModelExtras(result, model);
+    result.setExtra("peak_buttons", (double)peakButtons);
+    result.setExtra("frames_per_cycle", options.cycles ? (double)recorder.events() / options.cycles : 0);
+    result.setExtra("incomplete_animations", incomplete);
+    
+    return result;
+}
+
+const vector<ScenarioInfo>& scenarios()
+{
+    static const vector<ScenarioInfo> ret = {
+        { "startup", "N apps x M windows enumerated at launch, cold and from a snapshot", &startup },
+        { "title-storm", "every window retitled 'rate' times per second at 60fps", &titleStorm },
+        { "churn", "random window creation and destruction", &churn },
+        { "focus-ping-pong", "two apps alternating as frontmost", &focusPingPong },
+        { "animation", "full strip add and remove animation, per frame", &animation },
+    };
+    
+    return ret;
+}
+
+}
@@ -0,0 +1,62 @@
+/*---------------------------------------------------------------------------------------------
+ *  Copyright (c) Nicolas Jinchereau. All rights reserved.
+ *  Licensed under the MIT License. See License.txt in the project root for license information.
+ *--------------------------------------------------------------------------------------------*/
+
+#pragma once
+#include <bench/Bench.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+using namespace std;
+
+namespace bench
+{
+
+struct Options
+{
+    int apps = 20;
+    int windows = 5;
+    
+    // mean AX reply time, and apps that stop replying altogether
+    double latency = 0.002;
+    int hungApps = 0;
+    
+    // startup: enumerations, the first cold and the rest from the previous snapshot
+    int iterations = 10;
+    
+    // title storm: changes per second per window, over 'duration' simulated seconds
+    double rate = 10;
+    double duration = 10;
+    
+    // churn: window creations and destructions
+    int operations = 20000;
+    
+    // focus ping-pong: app switches
+    int switches = 20000;
+    
+    // animation: full strip add/remove cycles
+    int cycles = 10;
+    
+    float barWidth = 1920;
+    uint32_t seed = 1;
+};
+
+typedef Result (*Scenario)(const Options &options);
+
+struct ScenarioInfo
+{
+    const char *name;
+    const char *description;
+    Scenario run;
+};
+
+const vector<ScenarioInfo>& scenarios();
+
+Result startup(const Options &options);
+Result titleStorm(const Options &options);
+Result churn(const Options &options);
+Result focusPingPong(const Options &options);
+Result animation(const Options &options);
+
+}
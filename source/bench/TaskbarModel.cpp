@@ -0,0 +1,618 @@
+/*---------------------------------------------------------------------------------------------
+ *  Copyright (c) Nicolas Jinchereau. All rights reserved.
+ *  Licensed under the MIT License. See License.txt in the project root for license information.
+ *--------------------------------------------------------------------------------------------*/
+
+#include <bench/TaskbarModel.h>
+#include <algorithm>
+
+// space taken by a button's icon and padding, which is not available to its title
+#define BUTTON_TEXT_INSET           34
+
+namespace bench
+{
+
+using ax::Outcome;
+
+// roughly Helvetica 12
+static void setupMetrics(FixedAdvanceMetrics &metrics)
+{
+    for(uint32_t c = 'A'; c <= 'Z'; ++c)
+        metrics.setAdvance(c, 8.0f);
+    
+    for(uint32_t c : { ' ', 'f', 'j', 't', '.', ',', '-', '/' })
+        metrics.setAdvance(c, 3.3f);
+    
+    for(uint32_t c : { 'i', 'l', '|', '\'' })
+        metrics.setAdvance(c, 2.7f);
+    
+    for(uint32_t c : { 'm', 'w', 'M', 'W' })
+        metrics.setAdvance(c, 10.0f);
+}
+
+TaskbarModel::TaskbarModel(FakeAX &ax, float barWidth)
+    : _ax(ax),
+      _barWidth(barWidth),
+      _responsiveness([&ax]{ return ax.now(); }),
+      _metrics("Helvetica-12", 6.5f),
+      _layout(TaskLayout::taskbar()),
+      _needsUpdate(false),
+      _animating(false)
+{
+    setupMetrics(_metrics);
+}
+
+TaskbarModel::~TaskbarModel()
+{
+    
+}
+
+template<class F>
+AXResult TaskbarModel::_query(pid_t pid, F &&fn)
+{
+    // like the Query wrapper in UIElement.mm
+    if(!_responsiveness.shouldQuery(pid))
+    {
+        ++_stats.skippedQueries;
+        return AXResult::CannotComplete;
+    }
+    
+    AXResult result = fn(_responsiveness.timeoutFor(pid));
+    
+    if(result == AXResult::CannotComplete)
+    {
+        ++_stats.timeouts;
+        _responsiveness.record(pid, _ax.lastLatency(), Outcome::Timeout);
+    }
+    else
+    {
+        _responsiveness.record(pid, _ax.lastLatency(), Outcome::Success);
+    }
+    
+    return result;
+}
+
+TaskbarModel::App* TaskbarModel::_app(pid_t pid)
+{
+    auto it = _apps.find(pid);
+    return it != _apps.end() ? it->second.get() : nullptr;
+}
+
+TaskbarModel::Window* TaskbarModel::_windowFor(App &app, ElementID element)
+{
+    auto it = app.routes.find(element);
+    return it != app.routes.end() ? it->second : nullptr;
+}
+
+void TaskbarModel::restore(const ax::Snapshot &snapshot)
+{
+    _reconciler = ax::SnapshotReconciler(snapshot);
+    _placeholders.clear();
+    
+    for(auto &entry : snapshot.entries)
+    {
+        auto button = make_shared<Button>();
+        button->bundleID = entry.bundleID;
+        button->currentWidth = BUTTON_SIZE;
+        button->keep = true;
+        button->focused = entry.focused;
+        button->placeholder = true;
+        _setTitle(*button, entry.title);
+        
+        _placeholders.push_back(button);
+        _buttons.push_back(button);
+    }
+    
+    _animating = true;
+}
+
+void TaskbarModel::start()
+{
+    for(pid_t pid : _ax.applications())
+        addApplication(pid);
+    
+    focusFrontmost();
+}
+
+void TaskbarModel::addApplication(pid_t pid)
+{
+    if(_apps.count(pid))
+        return;
+    
+    unique_ptr<App> app(new App());
+    app->pid = pid;
+    app->bundleID = _ax.bundleID(pid);
+    app->hidden = _ax.isHidden(pid);
+    
+    if(app->hidden)
+        _focus.hidden(pid);
+    
+    if(_updateApp(*app) != 0)
+        _needsUpdate = true;
+    
+    _apps[pid] = move(app);
+}
+
+void TaskbarModel::focusFrontmost()
+{
+    if(pid_t pid = _ax.frontmost())
+        _focus.activated(pid);
+    
+    _updateFocus(true);
+}
+
+void TaskbarModel::dropPlaceholders()
+{
+    for(size_t index : _reconciler.unclaimed())
+    {
+        if(auto &button = _placeholders[index])
+        {
+            button->keep = false;
+            _animating = true;
+        }
+    }
+    
+    _placeholders.clear();
+    _reconciler = ax::SnapshotReconciler();
+}
+
+int TaskbarModel::_updateApp(App &app)
+{
+    if(!app.dirty)
+        return 0;
+    
+    vector<ElementID> elements;
+    AXResult result = _query(app.pid, [&](float timeout){
+        return _ax.copyWindows(app.pid, timeout, elements);
+    });
+    
+    if(result == AXResult::CannotComplete)
+        return 1;
+    
+    int errors = 0;
+    
+    for(ElementID element : elements)
+    {
+        if(!_windowFor(app, element))
+            errors += _addWindow(app, element);
+    }
+    
+    if(errors == 0)
+        app.dirty = false;
+    
+    return errors;
+}
+
+int TaskbarModel::_addWindow(App &app, ElementID element)
+{
+    string title;
+    AXResult result = _query(app.pid, [&](float timeout){
+        return _ax.copyTitle(app.pid, element, timeout, title);
+    });
+    
+    if(result == AXResult::CannotComplete)
+    {
+        app.dirty = true;
+        return 1;
+    }
+    
+    unique_ptr<Window> window(new Window());
+    window->pid = app.pid;
+    window->element = element;
+    window->title = title;
+    
+    // like Window::update subscribing to its app's observer
+    app.routes[element] = window.get();
+    
+    if(!app.hidden)
+        _createButton(window.get(), app.bundleID);
+    
+    _focus.windowAdded(app.pid, window.get());
+    app.windows.push_back(move(window));
+    
+    return 0;
+}
+
+void TaskbarModel::_removeWindow(App &app, Window *window)
+{
+    app.routes.erase(window->element);
+    
+    _destroyButton(window);
+    _focus.windowDestroyed(app.pid, window);
+    
+    auto it = find_if(app.windows.begin(), app.windows.end(),
+                      [window](const unique_ptr<Window> &w){ return w.get() == window; });
+    
+    if(it != app.windows.end())
+        app.windows.erase(it);
+}
+
+void TaskbarModel::_createButton(Window *window, const string &bundleID)
+{
+    if(window->button)
+        return;
+    
+    // take over the button painted for this window from the last snapshot
+    int index = _reconciler.claim(bundleID, window->title);
+    if(index >= 0 && _placeholders[index])
+    {
+        auto button = _placeholders[index];
+        _placeholders[index] = nullptr;
+        _bindButton(button, window, bundleID);
+        ++_stats.placeholdersClaimed;
+        return;
+    }
+    
+    auto button = make_shared<Button>();
+    button->currentWidth = 0.5f;
+    _bindButton(button, window, bundleID);
+    _buttons.push_back(button);
+    
+    ++_stats.buttonsAdded;
+    _animating = true;
+}
+
+void TaskbarModel::_bindButton(const shared_ptr<Button> &button, Window *window, const string &bundleID)
+{
+    button->window = window;
+    button->bundleID = bundleID;
+    button->keep = true;
+    button->focused = false;
+    button->placeholder = false;
+    _setTitle(*button, window->title);
+    
+    window->button = button;
+}
+
+void TaskbarModel::_destroyButton(Window *window)
+{
+    if(auto &button = window->button)
+    {
+        button->window = nullptr;
+        button->keep = false;
+        button.reset();
+        
+        ++_stats.buttonsRemoved;
+        _animating = true;
+    }
+}
+
+void TaskbarModel::_setTitle(Button &button, const string &title)
+{
+    if(button.run && button.title == title)
+        return;
+    
+    // like -[HoverButtonCell setTitle:]
+    button.title = title;
+    button.run = _titles.measure(title, _metrics);
+}
+
+void TaskbarModel::dispatch(const Event &event)
+{
+    ++_stats.notifications;
+    
+    App *app = _app(event.pid);
+    if(!app)
+    {
+        ++_stats.unrouted;
+        return;
+    }
+    
+    switch(event.notification)
+    {
+        case Notification::AppShown:
+        {
+            app->hidden = false;
+            
+            for(auto &win : app->windows)
+                _createButton(win.get(), app->bundleID);
+            
+            _focus.shown(app->pid);
+            _updateFocus(true);
+            break;
+        }
+        case Notification::AppHidden:
+        {
+            app->hidden = true;
+            
+            _focus.hidden(app->pid);
+            _updateFocus(true);
+            
+            for(auto &win : app->windows)
+                _destroyButton(win.get());
+            
+            break;
+        }
+        case Notification::AppActivated:
+        {
+            _focus.activated(app->pid);
+            _updateFocus(true);
+            break;
+        }
+        case Notification::AppDeactivated:
+        {
+            _focus.deactivated(app->pid);
+            _updateFocus(true);
+            break;
+        }
+        case Notification::WindowCreated:
+        {
+            if(!_windowFor(*app, event.element) && _addWindow(*app, event.element) != 0)
+                _needsUpdate = true;
+            
+            break;
+        }
+        case Notification::WindowDestroyed:
+        {
+            if(Window *win = _windowFor(*app, event.element))
+            {
+                _removeWindow(*app, win);
+                _updateFocus(false);
+            }
+            else
+            {
+                ++_stats.unrouted;
+            }
+            
+            break;
+        }
+        case Notification::TitleChanged:
+        {
+            Window *win = _windowFor(*app, event.element);
+            if(!win)
+            {
+                ++_stats.unrouted;
+                break;
+            }
+            
+            string title;
+            AXResult result = _query(app->pid, [&](float timeout){
+                return _ax.copyTitle(app->pid, win->element, timeout, title);
+            });
+            
+            if(result == AXResult::CannotComplete)
+            {
+                _needsUpdate = true;
+            }
+            else if(result == AXResult::Success && title != win->title)
+            {
+                // like -[TaskBarWindow renameWindow:]
+                win->title = title;
+                if(win->button)
+                    _setTitle(*win->button, title);
+                
+                ++_stats.titleChanges;
+            }
+            
+            break;
+        }
+        case Notification::MainWindowChanged:
+        {
+            _focus.mainWindowChanged(app->pid, _windowFor(*app, event.element));
+            _updateFocus(true);
+            break;
+        }
+    }
+}
+
+size_t TaskbarModel::dispatchAll()
+{
+    size_t count = 0;
+    
+    Event event;
+    while(_ax.poll(event))
+    {
+        dispatch(event);
+        ++count;
+    }
+    
+    return count;
+}
+
+void TaskbarModel::terminated(pid_t pid)
+{
+    App *app = _app(pid);
+    if(!app)
+        return;
+    
+    for(auto &win : app->windows)
+        _destroyButton(win.get());
+    
+    _focus.terminated(pid);
+    _updateFocus(false);
+    
+    _responsiveness.remove(pid);
+    _apps.erase(pid);
+}
+
+int TaskbarModel::retry()
+{
+    if(!_needsUpdate)
+        return 0;
+    
+    ++_stats.retries;
+    _needsUpdate = false;
+    
+    int errors = 0;
+    
+    for(auto &kv : _apps)
+        errors += _updateApp(*kv.second);
+    
+    if(_focus.needsQuery())
+    {
+        if(!_focus.resolve(_focusResolver()))
+            ++errors;
+        
+        _updateFocus(false);
+    }
+    
+    if(errors)
+        _needsUpdate = true;
+    
+    return errors;
+}
+
+bool TaskbarModel::needsRetry() const
+{
+    return _needsUpdate;
+}
+
+ax::FocusTracker::Resolver TaskbarModel::_focusResolver()
+{
+    return [this](pid_t pid, const void *&window)
+    {
+        App *app = _app(pid);
+        if(!app)
+            return ax::FocusTracker::MainWindow::None;
+        
+        ElementID element = 0;
+        AXResult result = _query(pid, [&](float timeout){
+            return _ax.copyMainWindow(pid, timeout, element);
+        });
+        
+        if(result == AXResult::CannotComplete)
+            return ax::FocusTracker::MainWindow::Unknown;
+        
+        if(result == AXResult::Success)
+        {
+            window = _windowFor(*app, element);
+            if(window)
+                return ax::FocusTracker::MainWindow::Found;
+        }
+        
+        // a dirty app has windows that failed to be added, and one may be the main window
+        if(app->dirty)
+            return ax::FocusTracker::MainWindow::Unknown;
+        
+        // no main window, or one that isn't on the taskbar
+        return ax::FocusTracker::MainWindow::None;
+    };
+}
+
+void TaskbarModel::_updateFocus(bool resolveNow)
+{
+    if(_focus.settle(resolveNow, _focusResolver()))
+        _needsUpdate = true;
+    
+    const void *previous = nullptr;
+    
+    if(_focus.takeFocusChange(previous))
+    {
+        Window *win = (Window*)_focus.focused();
+        
+        // the previously focused window may already be gone, so its button is looked up by value
+        for(auto &button : _buttons)
+        {
+            if(button->focused && button->window == previous)
+                button->focused = false;
+        }
+        
+        if(win && win->button)
+            win->button->focused = true;
+    }
+}
+
+bool TaskbarModel::step(float deltaTime)
+{
+    ++_stats.frames;
+    
+    int maxButtonSize = _layout.maxButtonWidth(_barWidth, _buttons.size());
+    bool didUpdateButton = false;
+    
+    for(auto it = _buttons.begin(); it != _buttons.end(); )
+    {
+        Button &button = **it;
+        
+        if(_layout.animate(button.currentWidth, button.keep, deltaTime))
+            didUpdateButton = true;
+        
+        if(!_layout.isCollapsed(button.currentWidth))
+        {
+            button.frameWidth = _layout.visibleWidth(button.currentWidth, maxButtonSize);
+            
+            // like -[HoverButtonCell drawWithFrame:inView:]
+            button.run->fit((float)(button.frameWidth - BUTTON_TEXT_INSET));
+            
+            ++it;
+        }
+        else
+        {
+            it = _buttons.erase(it);
+        }
+    }
+    
+    _animating = didUpdateButton;
+    return didUpdateButton;
+}
+
+bool TaskbarModel::isAnimating() const
+{
+    return _animating;
+}
+
+ax::Snapshot TaskbarModel::snapshot() const
+{
+    ax::Snapshot ret;
+    ret.entries.reserve(_buttons.size());
+    
+    for(auto &button : _buttons)
+    {
+        if(!button->keep)
+            continue;
+        
+        ax::SnapshotEntry entry;
+        entry.bundleID = button->bundleID;
+        entry.title = button->title;
+        entry.focused = button->focused;
+        ret.entries.push_back(move(entry));
+    }
+    
+    return ret;
+}
+
+size_t TaskbarModel::buttonCount() const
+{
+    return _buttons.size();
+}
+
+size_t TaskbarModel::windowCount() const
+{
+    size_t count = 0;
+    
+    for(auto &kv : _apps)
+        count += kv.second->windows.size();
+    
+    return count;
+}
+
+size_t TaskbarModel::routeCount() const
+{
+    size_t count = 0;
+    
+    for(auto &kv : _apps)
+        count += kv.second->routes.size();
+    
+    return count;
+}
+
+const ax::FocusTracker& TaskbarModel::focus() const
+{
+    return _focus;
+}
+
+const ax::ResponsivenessTracker& TaskbarModel::responsiveness() const
+{
+    return _responsiveness;
+}
+
+const TextFitCache& TaskbarModel::titles() const
+{
+    return _titles;
+}
+
+const TaskbarStats& TaskbarModel::stats() const
+{
+    return _stats;
+}
+
+}
@@ -0,0 +1,175 @@
+/*---------------------------------------------------------------------------------------------
+ *  Copyright (c) Nicolas Jinchereau. All rights reserved.
+ *  Licensed under the MIT License. See License.txt in the project root for license information.
+ *--------------------------------------------------------------------------------------------*/
+
+#pragma once
+#include <bench/FakeAX.h>
+#include <ax/FocusTracker.h>
+#include <ax/Responsiveness.h>
+#include <ax/Snapshot.h>
+#include <ui/TextFit.h>
+#include <ui/TaskLayout.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <unordered_map>
+using namespace std;
+
+namespace bench
+{
+
+struct TaskbarStats
+{
+    // notifications handled, and those for elements without a route
+    uint64_t notifications = 0;
+    uint64_t unrouted = 0;
+    
+    uint64_t titleChanges = 0;
+    uint64_t buttonsAdded = 0;
+    uint64_t buttonsRemoved = 0;
+    uint64_t placeholdersClaimed = 0;
+    uint64_t frames = 0;
+    
+    // queries skipped while an app's circuit was open, and queries that timed out
+    uint64_t skippedQueries = 0;
+    uint64_t timeouts = 0;
+    
+    uint64_t retries = 0;
+};
+
+// A model of the taskbar's update path, for benchmarking off macOS.
+//
+// Application, Window, Observer and TaskBarWindow are Objective-C++ over
+// AppKit and ApplicationServices, so the glue between notifications, AX
+// queries and buttons is re-implemented here against FakeAX rather than
+// run as shipped, and its costs are the model's. The focus tracker,
+// responsiveness tracker, snapshot reconciler, title fitting and layout it
+// drives are the app's own Cocoa-free components.
+class TaskbarModel
+{
+public:
+    TaskbarModel(FakeAX &ax, float barWidth);
+    ~TaskbarModel();
+    
+    // paints placeholder buttons, like -[TaskBarWindow restoreSnapshot:]
+    void restore(const ax::Snapshot &snapshot);
+    
+    // enumerates the running apps and their windows, like -[AXWorkspace init]
+    void start();
+    
+    // enumerates one app and its windows, like -[AXWorkspace onAppLaunched:]
+    void addApplication(pid_t pid);
+    
+    // focuses the main window of the frontmost app, as done at the end of start()
+    void focusFrontmost();
+    
+    // removes placeholders that no live window claimed
+    void dropPlaceholders();
+    
+    // handles one notification, like Observer::_proxy and the Application handlers
+    void dispatch(const Event &event);
+    
+    // handles every queued notification, and returns how many there were
+    size_t dispatchAll();
+    
+    // like -[AXWorkspace onAppTerminated:]
+    void terminated(pid_t pid);
+    
+    // like -[AXWorkspace retryUpdate], returns the errors left
+    int retry();
+    bool needsRetry() const;
+    
+    // One display link frame, like -[TaskBarWindow updateAnimation] followed by drawing
+    // each visible button. Returns false once all buttons have finished animating.
+    bool step(float deltaTime);
+    bool isAnimating() const;
+    
+    // like -[TaskBarWindow snapshotWithIconDirectory:]
+    ax::Snapshot snapshot() const;
+    
+    size_t buttonCount() const;
+    size_t windowCount() const;
+    size_t routeCount() const;
+    
+    const ax::FocusTracker& focus() const;
+    const ax::ResponsivenessTracker& responsiveness() const;
+    const TextFitCache& titles() const;
+    const TaskbarStats& stats() const;
+
+private:
+    struct Window;
+    
+    struct Button
+    {
+        Window *window = nullptr;
+        string bundleID;
+        string title;
+        shared_ptr<TextRun> run;
+        float currentWidth = 0;
+        int frameWidth = 0;
+        bool keep = false;
+        bool focused = false;
+        bool placeholder = false;
+    };
+    
+    struct Window
+    {
+        pid_t pid = 0;
+        ElementID element = 0;
+        string title;
+        shared_ptr<Button> button;
+    };
+    
+    struct App
+    {
+        pid_t pid = 0;
+        string bundleID;
+        bool hidden = false;
+        bool dirty = true;
+        vector<unique_ptr<Window>> windows;
+        
+        // like Observer::_targets
+        unordered_map<ElementID, Window*> routes;
+    };
+    
+    template<class F>
+    AXResult _query(pid_t pid, F &&fn);
+    
+    App* _app(pid_t pid);
+    Window* _windowFor(App &app, ElementID element);
+    
+    int _updateApp(App &app);
+    int _addWindow(App &app, ElementID element);
+    void _removeWindow(App &app, Window *window);
+    
+    void _createButton(Window *window, const string &bundleID);
+    void _destroyButton(Window *window);
+    void _bindButton(const shared_ptr<Button> &button, Window *window, const string &bundleID);
+    void _setTitle(Button &button, const string &title);
+    
+    ax::FocusTracker::Resolver _focusResolver();
+    void _updateFocus(bool resolveNow);
+    
+    FakeAX &_ax;
+    float _barWidth;
+    
+    unordered_map<pid_t, unique_ptr<App>> _apps;
+    vector<shared_ptr<Button>> _buttons;
+    vector<shared_ptr<Button>> _placeholders;
+    ax::SnapshotReconciler _reconciler;
+    
+    ax::FocusTracker _focus;
+    ax::ResponsivenessTracker _responsiveness;
+    
+    FixedAdvanceMetrics _metrics;
+    TextFitCache _titles;
+    TaskLayout _layout;
+    
+    TaskbarStats _stats;
+    bool _needsUpdate;
+    bool _animating;
+};
+
+}
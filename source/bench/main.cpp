@@ -0,0 +1,213 @@
+/*---------------------------------------------------------------------------------------------
+ *  Copyright (c) Nicolas Jinchereau. All rights reserved.
+ *  Licensed under the MIT License. See License.txt in the project root for license information.
+ *--------------------------------------------------------------------------------------------*/
+
+#include <bench/Bench.h>
+#include <bench/Scenarios.h>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace bench;
+
+static void usage()
+{
+    cout << "usage: taskbar-bench [options] [scenario...]\n"
+            "\n"
+            "Benchmarks a model of the taskbar's update path against a fake\n"
+            "accessibility backend. Each scenario runs in its own process.\n"
+            "\n"
+            "options:\n"
+            "  --apps N         applications (default 20)\n"
+            "  --windows M      windows per application (default 5)\n"
+            "  --latency S      mean AX reply time in seconds (default 0.002)\n"
+            "  --hung N         applications that never reply (default 0)\n"
+            "  --iterations N   startup: enumerations (default 10)\n"
+            "  --rate R         title-storm: changes per second per window (default 10)\n"
+            "  --duration S     title-storm: simulated seconds (default 10)\n"
+            "  --operations N   churn: window creations and destructions (default 20000)\n"
+            "  --switches N     focus-ping-pong: app switches (default 20000)\n"
+            "  --cycles N       animation: add/remove cycles (default 10)\n"
+            "  --bar-width W    taskbar width in points (default 1920)\n"
+            "  --seed S         random seed (default 1)\n"
+            "  --output FILE    write the JSON report to FILE instead of stdout\n"
+            "\n"
+            "scenarios (default all):\n";
+    
+    for(auto &scenario : scenarios())
+        printf("  %-16s %s\n", scenario.name, scenario.description);
+}
+
+// Runs 'scenario' in a forked process, so that its peak RSS is its own rather than the
+// high-water mark of every scenario run before it, and returns its result as JSON.
+static bool runIsolated(const ScenarioInfo &scenario, const Options &options, string &json)
+{
+    int fds[2];
+    if(pipe(fds) != 0)
+        return false;
+    
+    pid_t pid = fork();
+    
+    if(pid < 0)
+    {
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+    
+    if(pid == 0)
+    {
+        close(fds[0]);
+        
+        int status = 0;
+        
+        try
+        {
+            string out = scenario.run(options).toJSON(4);
+            
+            for(size_t written = 0; written < out.size(); )
+            {
+                ssize_t n = write(fds[1], out.data() + written, out.size() - written);
+                if(n <= 0)
+                {
+                    status = 1;
+                    break;
+                }
+                
+                written += (size_t)n;
+            }
+        }
+        catch(exception &ex)
+        {
+            cerr << "error: " << ex.what() << endl;
+            status = 1;
+        }
+        
+        close(fds[1]);
+        _exit(status);
+    }
+    
+    close(fds[1]);
+    
+    json.clear();
+    char buffer[4096];
+    ssize_t n;
+    
+    while((n = read(fds[0], buffer, sizeof(buffer))) > 0)
+        json.append(buffer, (size_t)n);
+    
+    close(fds[0]);
+    
+    int status = 0;
+    if(waitpid(pid, &status, 0) != pid)
+        return false;
+    
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0 && !json.empty();
+}
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    vector<const ScenarioInfo*> selected;
+    string output;
+    
+    try
+    {
+        for(int i = 1; i < argc; ++i)
+        {
+            string arg = argv[i];
+            
+            auto value = [&]() -> string {
+                if(i + 1 >= argc)
+                    throw runtime_error("missing value for " + arg);
+                return argv[++i];
+            };
+            
+            if(arg == "-h" || arg == "--help") { usage(); return 0; }
+            else if(arg == "--apps") options.apps = stoi(value());
+            else if(arg == "--windows") options.windows = stoi(value());
+            else if(arg == "--latency") options.latency = stod(value());
+            else if(arg == "--hung") options.hungApps = stoi(value());
+            else if(arg == "--iterations") options.iterations = stoi(value());
+            else if(arg == "--rate") options.rate = stod(value());
+            else if(arg == "--duration") options.duration = stod(value());
+            else if(arg == "--operations") options.operations = stoi(value());
+            else if(arg == "--switches") options.switches = stoi(value());
+            else if(arg == "--cycles") options.cycles = stoi(value());
+            else if(arg == "--bar-width") options.barWidth = stof(value());
+            else if(arg == "--seed") options.seed = (uint32_t)stoul(value());
+            else if(arg == "--output") output = value();
+            else
+            {
+                const ScenarioInfo *found = nullptr;
+                
+                for(auto &scenario : scenarios())
+                {
+                    if(arg == scenario.name)
+                        found = &scenario;
+                }
+                
+                if(!found)
+                    throw runtime_error("unknown scenario or option: " + arg);
+                
+                selected.push_back(found);
+            }
+        }
+        
+        if(options.apps < 0 || options.windows < 0 || options.hungApps < 0 || options.latency < 0)
+            throw runtime_error("counts and latencies must not be negative");
+    }
+    catch(exception &ex)
+    {
+        cerr << "error: " << ex.what() << "\n\n";
+        usage();
+        return 1;
+    }
+    
+    if(selected.empty())
+    {
+        for(auto &scenario : scenarios())
+            selected.push_back(&scenario);
+    }
+    
+    vector<string> results;
+    
+    for(auto scenario : selected)
+    {
+        cerr << "running " << scenario->name << "..." << endl;
+        
+        string result;
+        if(!runIsolated(*scenario, options, result))
+        {
+            cerr << "error: " << scenario->name << " failed" << endl;
+            return 1;
+        }
+        
+        results.push_back(result);
+    }
+    
+    string json = reportJSON(results);
+    
+    if(output.empty())
+    {
+        cout << json;
+    }
+    else
+    {
+        ofstream file(output);
+        file << json;
+        
+        if(!file)
+        {
+            cerr << "error: failed to write " << output << endl;
+            return 1;
+        }
+    }
+    
+    return 0;
+}
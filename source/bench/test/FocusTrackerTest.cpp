@@ -0,0 +1,506 @@
+/*---------------------------------------------------------------------------------------------
+ *  Copyright (c) Nicolas Jinchereau. All rights reserved.
+ *  Licensed under the MIT License. See License.txt in the project root for license information.
+ *--------------------------------------------------------------------------------------------*/
+
+#include <test/Test.h>
+#include <ax/FocusTracker.h>
+#include <algorithm>
+#include <map>
+#include <random>
+#include <set>
+#include <vector>
+
+using namespace ax;
+
+// The apps and windows the tracker is told about. Each event changes the world first,
+// like AX does before its notifications arrive, then sends the notifications the
+// workspace would, settling the tracker after each one the way -updateFocus: does.
+class World
+{
+public:
+    World(uint32_t seed, double failRate)
+        : _random(seed),
+          _failRate(failRate),
+          _nextPID(100),
+          _nextWindow(1),
+          _frontmost(0),
+          _reported(nullptr),
+          _queries(0),
+          _needsRetry(false)
+    {
+        
+    }
+    
+    pid_t launch()
+    {
+        pid_t pid = _nextPID++;
+        _apps[pid];
+        return pid;
+    }
+    
+    void activate(pid_t pid)
+    {
+        if(_frontmost == pid)
+            return;
+        
+        if(_frontmost)
+            deactivate();
+        
+        _frontmost = pid;
+        tracker.activated(pid);
+        _settle(true);
+    }
+    
+    // the frontmost app deactivates without another one activating
+    void deactivate()
+    {
+        pid_t pid = _frontmost;
+        _frontmost = 0;
+        tracker.deactivated(pid);
+        _settle(true);
+    }
+    
+    void setHidden(pid_t pid, bool hidden)
+    {
+        _apps[pid].hidden = hidden;
+        
+        if(hidden)
+            tracker.hidden(pid);
+        else
+            tracker.shown(pid);
+        
+        _settle(true);
+    }
+    
+    // 'notifyMain' false drops the main window notification, which AX doesn't always send
+    uintptr_t createWindow(pid_t pid, bool notifyMain)
+    {
+        App &app = _apps[pid];
+        uintptr_t window = _nextWindow++;
+        app.windows.push_back(window);
+        
+        bool becameMain = (app.main == 0);
+        if(becameMain)
+            app.main = window;
+        
+        _announced.insert(window);
+        tracker.windowAdded(pid, key(window));
+        _settle(true);
+        
+        if(becameMain && notifyMain)
+        {
+            tracker.mainWindowChanged(pid, key(window));
+            _settle(true);
+        }
+        
+        return window;
+    }
+    
+    // the main window changes to a new window before the window itself is reported
+    void createMainWindowLate(pid_t pid)
+    {
+        App &app = _apps[pid];
+        uintptr_t window = _nextWindow++;
+        app.windows.push_back(window);
+        app.main = window;
+        
+        tracker.mainWindowChanged(pid, nullptr);
+        _settle(true);
+        
+        _announced.insert(window);
+        tracker.windowAdded(pid, key(window));
+        _settle(true);
+    }
+    
+    void destroyWindow(pid_t pid, uintptr_t window, bool notifyMain)
+    {
+        App &app = _apps[pid];
+        app.windows.erase(find(app.windows.begin(), app.windows.end(), window));
+        _announced.erase(window);
+        
+        bool mainChanged = (app.main == window);
+        if(mainChanged)
+            app.main = app.windows.empty() ? 0 : app.windows.back();
+        
+        tracker.windowDestroyed(pid, key(window));
+        _settle(false);
+        
+        if(mainChanged && app.main && notifyMain)
+        {
+            tracker.mainWindowChanged(pid, key(app.main));
+            _settle(true);
+        }
+    }
+    
+    // A panel, or another window the workspace doesn't list, becomes the main window.
+    // It is never announced, and the main window notification names no tracked window.
+    void openPanel(pid_t pid)
+    {
+        App &app = _apps[pid];
+        uintptr_t panel = _nextWindow++;
+        app.panels.push_back(panel);
+        app.main = panel;
+        
+        tracker.mainWindowChanged(pid, nullptr);
+        _settle(true);
+    }
+    
+    void closePanel(pid_t pid, uintptr_t panel)
+    {
+        App &app = _apps[pid];
+        app.panels.erase(find(app.panels.begin(), app.panels.end(), panel));
+        
+        if(app.main != panel)
+            return;
+        
+        app.main = app.windows.empty() ? 0 : app.windows.back();
+        
+        if(app.main)
+        {
+            tracker.mainWindowChanged(pid, key(app.main));
+            _settle(true);
+        }
+    }
+    
+    void setMain(pid_t pid, uintptr_t window)
+    {
+        _apps[pid].main = window;
+        tracker.mainWindowChanged(pid, key(window));
+        _settle(true);
+    }
+    
+    void terminate(pid_t pid)
+    {
+        for(uintptr_t window : _apps[pid].windows)
+            _announced.erase(window);
+        
+        _apps.erase(pid);
+        
+        if(_frontmost == pid)
+            _frontmost = 0;
+        
+        tracker.terminated(pid);
+        _settle(false);
+    }
+    
+    // retries a deferred query until it succeeds, as the workspace's retry timer does
+    void retry()
+    {
+        for(int attempt = 0; attempt < 100 && tracker.needsQuery(); ++attempt)
+            tracker.resolve(resolver());
+        
+        CHECK(!tracker.needsQuery());
+        _needsRetry = false;
+        _check();
+    }
+    
+    // a random event of any type
+    void step()
+    {
+        if(_apps.empty() || (_apps.size() < 6 && _chance(0.05)))
+            launch();
+        
+        pid_t pid = _randomApp();
+        const vector<uintptr_t> &windows = _apps[pid].windows;
+        const vector<uintptr_t> &panels = _apps[pid].panels;
+        
+        switch(uniform_int_distribution<int>(0, 11)(_random))
+        {
+            case 0: activate(pid); break;
+            case 1: if(_frontmost) deactivate(); break;
+            case 2: setHidden(pid, !_apps[pid].hidden); break;
+            case 3: createWindow(pid, _chance(0.5)); break;
+            case 4: createMainWindowLate(pid); break;
+            case 5: if(!windows.empty()) destroyWindow(pid, _randomWindow(windows), _chance(0.5)); break;
+            case 6: if(!windows.empty()) setMain(pid, _randomWindow(windows)); break;
+            case 7: if(_chance(0.2)) terminate(pid); break;
+            case 8: openPanel(pid); break;
+            case 9: if(!panels.empty()) closePanel(pid, _randomWindow(panels)); break;
+            default: if(_needsRetry) retry(); break;
+        }
+    }
+    
+    // the main window of the frontmost app, unless it is hidden or not listed
+    const void* truth() const
+    {
+        auto it = _apps.find(_frontmost);
+        if(it == _apps.end() || it->second.hidden || !_announced.count(it->second.main))
+            return nullptr;
+        
+        return key(it->second.main);
+    }
+    
+    FocusTracker::Resolver resolver()
+    {
+        return [this](pid_t pid, const void *&window)
+        {
+            ++_queries;
+            
+            auto it = _apps.find(pid);
+            if(it == _apps.end())
+                return FocusTracker::MainWindow::None;
+            
+            if(_chance(_failRate))
+                return FocusTracker::MainWindow::Unknown;
+            
+            const App &app = it->second;
+            
+            if(_announced.count(app.main))
+            {
+                window = key(app.main);
+                return FocusTracker::MainWindow::Found;
+            }
+            
+            // a window that isn't announced yet may turn out to be the main window
+            for(uintptr_t w : app.windows)
+            {
+                if(!_announced.count(w))
+                    return FocusTracker::MainWindow::Unknown;
+            }
+            
+            // no main window, or a panel
+            return FocusTracker::MainWindow::None;
+        };
+    }
+    
+    uint64_t queries() const
+    {
+        return _queries;
+    }
+    
+    bool needsRetry() const
+    {
+        return _needsRetry;
+    }
+    
+    static const void* key(uintptr_t window)
+    {
+        return (const void*)window;
+    }
+    
+    FocusTracker tracker;
+
+private:
+    struct App
+    {
+        vector<uintptr_t> windows;
+        vector<uintptr_t> panels;
+        uintptr_t main = 0;
+        bool hidden = false;
+    };
+    
+    bool _chance(double p)
+    {
+        return uniform_real_distribution<double>(0, 1)(_random) < p;
+    }
+    
+    pid_t _randomApp()
+    {
+        auto it = _apps.begin();
+        advance(it, uniform_int_distribution<size_t>(0, _apps.size() - 1)(_random));
+        return it->first;
+    }
+    
+    uintptr_t _randomWindow(const vector<uintptr_t> &windows)
+    {
+        return windows[uniform_int_distribution<size_t>(0, windows.size() - 1)(_random)];
+    }
+    
+    void _settle(bool resolveNow)
+    {
+        if(tracker.settle(resolveNow, resolver()))
+            _needsRetry = true;
+        
+        _check();
+    }
+    
+    void _check()
+    {
+        CHECK_EQ(tracker.checkInvariants(), string());
+        CHECK_EQ(tracker.frontmost(), _frontmost);
+        
+        // while ambiguous, nothing is focused until the query succeeds
+        if(tracker.needsQuery())
+        {
+            CHECK_EQ(tracker.ambiguousApp(), _frontmost);
+            CHECK(_needsRetry);
+        }
+        else
+        {
+            CHECK(tracker.focused() == truth());
+        }
+        
+        const void *previous = nullptr;
+        bool changed = tracker.takeFocusChange(previous);
+        
+        CHECK_EQ(changed, tracker.focused() != _reported);
+        
+        if(changed)
+        {
+            CHECK(previous == _reported);
+            _reported = tracker.focused();
+        }
+        
+        CHECK(!tracker.takeFocusChange(previous));
+    }
+    
+    mt19937 _random;
+    double _failRate;
+    pid_t _nextPID;
+    uintptr_t _nextWindow;
+    map<pid_t, App> _apps;
+    set<uintptr_t> _announced;
+    pid_t _frontmost;
+    const void *_reported;
+    uint64_t _queries;
+    bool _needsRetry;
+};
+
+static void testKnownMainWindow()
+{
+    World world(1, 0);
+    pid_t a = world.launch();
+    pid_t b = world.launch();
+    
+    uintptr_t wa = world.createWindow(a, true);
+    uintptr_t wb = world.createWindow(b, true);
+    
+    // main windows reported by notifications are never queried
+    world.activate(a);
+    world.activate(b);
+    world.activate(a);
+    CHECK(world.tracker.focused() == World::key(wa));
+    CHECK_EQ(world.queries(), (uint64_t)0);
+    
+    world.setHidden(a, true);
+    CHECK(world.tracker.focused() == nullptr);
+    
+    world.setHidden(a, false);
+    world.setMain(b, wb);
+    CHECK(world.tracker.focused() == World::key(wa));
+    CHECK_EQ(world.queries(), (uint64_t)0);
+}
+
+static void testDeferredQuery()
+{
+    World world(1, 0);
+    pid_t a = world.launch();
+    uintptr_t w1 = world.createWindow(a, true);
+    uintptr_t w2 = world.createWindow(a, true);
+    
+    world.activate(a);
+    uint64_t queries = world.queries();
+    
+    // destroying the main window leaves the new one to a later query,
+    // and nothing is focused in the meantime
+    world.setMain(a, w2);
+    world.destroyWindow(a, w2, false);
+    CHECK(world.tracker.needsQuery());
+    CHECK(world.tracker.focused() == nullptr);
+    CHECK_EQ(world.queries(), queries);
+    
+    world.retry();
+    CHECK(world.tracker.focused() == World::key(w1));
+    CHECK_EQ(world.queries(), queries + 1);
+}
+
+static void testFailedQuery()
+{
+    // every query fails, so the state stays ambiguous and the retry is requested again
+    World world(1, 1.0);
+    pid_t a = world.launch();
+    world.createWindow(a, true);
+    
+    world.tracker.mainWindowChanged(a, nullptr);
+    world.tracker.activated(a);
+    
+    CHECK(world.tracker.settle(true, world.resolver()));
+    CHECK(!world.tracker.resolve(world.resolver()));
+    CHECK(world.tracker.needsQuery());
+    CHECK(world.tracker.focused() == nullptr);
+    CHECK_EQ(world.tracker.checkInvariants(), string());
+}
+
+static void testUnlistedMainWindow()
+{
+    World world(1, 0);
+    pid_t a = world.launch();
+    uintptr_t w = world.createWindow(a, true);
+    world.activate(a);
+    uint64_t queries = world.queries();
+    
+    // a panel as main window is queried once, then settles with nothing focused
+    world.openPanel(a);
+    CHECK(!world.tracker.needsQuery());
+    CHECK(!world.needsRetry());
+    CHECK(world.tracker.focused() == nullptr);
+    CHECK_EQ(world.queries(), queries + 1);
+    
+    world.setHidden(a, true);
+    world.setHidden(a, false);
+    CHECK_EQ(world.queries(), queries + 1);
+    
+    // a new window may take over as main window without saying so, so it is queried
+    uintptr_t w2 = world.createWindow(a, false);
+    CHECK_EQ(world.queries(), queries + 2);
+    CHECK(world.tracker.focused() == nullptr);
+    
+    world.setMain(a, w2);
+    CHECK(world.tracker.focused() == World::key(w2));
+    world.setMain(a, w);
+    CHECK(world.tracker.focused() == World::key(w));
+}
+
+static void testFocusChangeReport()
+{
+    World world(1, 0);
+    pid_t a = world.launch();
+    uintptr_t w = world.createWindow(a, true);
+    world.activate(a);
+    
+    // the destroyed window is still reported as the previous focus, for comparison
+    FocusTracker &tracker = world.tracker;
+    tracker.windowDestroyed(a, World::key(w));
+    
+    const void *previous = nullptr;
+    CHECK(tracker.takeFocusChange(previous));
+    CHECK(previous == World::key(w));
+    CHECK(!tracker.takeFocusChange(previous));
+}
+
+static void testRandomSequences()
+{
+    const double failRates[] = { 0, 0.3 };
+    
+    for(double failRate : failRates)
+    {
+        for(uint32_t seed = 1; seed <= 20; ++seed)
+        {
+            World world(seed, failRate);
+            
+            for(int i = 0; i < 5000 && _testFailures == 0; ++i)
+                world.step();
+            
+            world.retry();
+            
+            if(_testFailures)
+            {
+                cout << "failed with seed " << seed << ", fail rate " << failRate << endl;
+                return;
+            }
+        }
+    }
+}
+
+int main()
+{
+    testKnownMainWindow();
+    testDeferredQuery();
+    testFailedQuery();
+    testUnlistedMainWindow();
+    testFocusChangeReport();
+    testRandomSequences();
+    
+    return TEST_RESULT();
+}
@@ -0,0 +1,214 @@
+/*---------------------------------------------------------------------------------------------
+ *  Copyright (c) Nicolas Jinchereau. All rights reserved.
+ *  Licensed under the MIT License. See License.txt in the project root for license information.
+ *--------------------------------------------------------------------------------------------*/
+
+#include <test/Test.h>
+#include <ax/Responsiveness.h>
+#include <cmath>
+
+using namespace ax;
+
+typedef ResponsivenessTracker Tracker;
+
+static const pid_t PID = 100;
+
+// latencies that land in known histogram buckets
+static const double Fast = 0.001;   // bucket 1, limit 1ms
+static const double Slow = 0.02;    // bucket 6, limit 32ms
+static const double Slower = 0.1;   // bucket 8, limit 128ms
+static const double Hung = 0.4;     // bucket 10, limit 512ms
+
+static bool near(double a, double b)
+{
+    return fabs(a - b) < 1e-6;
+}
+
+static void reply(Tracker &tracker, double latency, int count = 1)
+{
+    for(int i = 0; i < count; ++i)
+        tracker.record(PID, latency, Outcome::Success);
+}
+
+static void timeout(Tracker &tracker, int count = 1)
+{
+    for(int i = 0; i < count; ++i)
+        tracker.record(PID, tracker.timeoutFor(PID), Outcome::Timeout);
+}
+
+static void testDefaultTimeout()
+{
+    double now = 0;
+    Tracker tracker([&]{ return now; });
+    
+    CHECK_EQ(tracker.timeoutFor(PID), AX_DEFAULT_TIMEOUT);
+    
+    reply(tracker, Slower, Tracker::MinSamples - 1);
+    CHECK_EQ(tracker.timeoutFor(PID), AX_DEFAULT_TIMEOUT);
+    
+    reply(tracker, Slower);
+    CHECK(near(tracker.timeoutFor(PID), LatencyHistogram::bucketLimit(8) * Tracker::TimeoutScale));
+    
+    // failures are replies too, and count toward the samples
+    Tracker failing([&]{ return now; });
+    
+    for(uint32_t i = 0; i < Tracker::MinSamples; ++i)
+        failing.record(PID, Slower, Outcome::Failure);
+    
+    CHECK(near(failing.timeoutFor(PID), LatencyHistogram::bucketLimit(8) * Tracker::TimeoutScale));
+    CHECK_EQ(failing.health(PID).failures, Tracker::MinSamples);
+}
+
+static void testTimeoutClamp()
+{
+    double now = 0;
+    
+    Tracker fast([&]{ return now; });
+    reply(fast, Fast, Tracker::MinSamples);
+    CHECK_EQ(fast.timeoutFor(PID), AX_MIN_TIMEOUT);
+    CHECK_EQ(to_string(fast.state(PID)), to_string(Health::Healthy));
+    
+    Tracker hung([&]{ return now; });
+    reply(hung, Hung, Tracker::MinSamples);
+    CHECK_EQ(hung.timeoutFor(PID), AX_MAX_TIMEOUT);
+    CHECK_EQ(to_string(hung.state(PID)), to_string(Health::Degraded));
+}
+
+static void testTimeoutsNotSampled()
+{
+    double now = 0;
+    Tracker tracker([&]{ return now; });
+    
+    reply(tracker, Slower, Tracker::MinSamples);
+    float adapted = tracker.timeoutFor(PID);
+    double p99 = tracker.health(PID).p99;
+    CHECK(adapted > AX_DEFAULT_TIMEOUT);
+    
+    // a timeout leaves the histogram alone, and caps the timeout at the default
+    timeout(tracker, Tracker::FailureThreshold - 1);
+    CHECK(near(tracker.health(PID).p99, p99));
+    CHECK_EQ(tracker.timeoutFor(PID), AX_DEFAULT_TIMEOUT);
+    CHECK_EQ(tracker.health(PID).timeouts, (uint32_t)Tracker::FailureThreshold - 1);
+    CHECK_EQ(tracker.health(PID).samples, Tracker::MinSamples + Tracker::FailureThreshold - 1);
+    
+    // timeouts alone never adapt the timeout of an unknown app
+    Tracker unknown([&]{ return now; });
+    timeout(unknown, Tracker::MinSamples);
+    CHECK_EQ(unknown.timeoutFor(PID), AX_DEFAULT_TIMEOUT);
+    CHECK(near(unknown.health(PID).p99, 0));
+    
+    // the next reply restores the adapted timeout
+    reply(tracker, Slower);
+    CHECK_EQ(tracker.timeoutFor(PID), adapted);
+}
+
+static void testCircuit()
+{
+    double now = 0;
+    Tracker tracker([&]{ return now; });
+    
+    timeout(tracker, Tracker::FailureThreshold - 1);
+    CHECK(tracker.shouldQuery(PID));
+    CHECK_EQ(to_string(tracker.state(PID)), to_string(Health::Healthy));
+    
+    // any reply resets the count of consecutive timeouts
+    tracker.record(PID, Fast, Outcome::Failure);
+    timeout(tracker, Tracker::FailureThreshold - 1);
+    CHECK(tracker.shouldQuery(PID));
+    
+    timeout(tracker);
+    CHECK_EQ(to_string(tracker.state(PID)), to_string(Health::Unresponsive));
+    
+    // while open, each skipped query saves a timeout
+    CHECK(!tracker.shouldQuery(PID));
+    CHECK(!tracker.shouldQuery(PID));
+    
+    AppHealth health = tracker.health(PID);
+    CHECK_EQ(health.skipped, (uint32_t)2);
+    CHECK(near(health.timeSaved, 2 * AX_DEFAULT_TIMEOUT));
+    CHECK(near(tracker.totalTimeSaved(), 2 * AX_DEFAULT_TIMEOUT));
+    
+    // other apps are unaffected
+    CHECK(tracker.shouldQuery(PID + 1));
+}
+
+static void testProbing()
+{
+    double now = 0;
+    Tracker tracker([&]{ return now; });
+    
+    timeout(tracker, Tracker::FailureThreshold);
+    CHECK_EQ(to_string(tracker.state(PID)), to_string(Health::Unresponsive));
+    
+    // each probe that times out doubles the wait for the next one, up to the maximum
+    double interval = Tracker::MinProbeInterval;
+    
+    for(int i = 0; i < 6; ++i)
+    {
+        now += interval - 0.01;
+        CHECK(!tracker.shouldQuery(PID));
+        
+        now += 0.01;
+        CHECK(tracker.shouldQuery(PID));
+        CHECK_EQ(to_string(tracker.state(PID)), to_string(Health::Probing));
+        
+        timeout(tracker);
+        CHECK_EQ(to_string(tracker.state(PID)), to_string(Health::Unresponsive));
+        
+        interval = fmin(interval * 2, Tracker::MaxProbeInterval);
+    }
+    
+    CHECK_EQ(interval, Tracker::MaxProbeInterval);
+    
+    // a reply to the probe closes the circuit
+    now += interval;
+    CHECK(tracker.shouldQuery(PID));
+    reply(tracker, Fast);
+    CHECK_EQ(to_string(tracker.state(PID)), to_string(Health::Healthy));
+    CHECK(tracker.shouldQuery(PID));
+    
+    // and the next time it opens, probing starts over at the minimum interval
+    timeout(tracker, Tracker::FailureThreshold);
+    now += Tracker::MinProbeInterval;
+    CHECK(tracker.shouldQuery(PID));
+    
+    tracker.remove(PID);
+    CHECK_EQ(to_string(tracker.state(PID)), to_string(Health::Healthy));
+    CHECK_EQ(tracker.health(PID).timeouts, (uint32_t)0);
+}
+
+static void testDecay()
+{
+    double now = 0;
+    Tracker tracker([&]{ return now; });
+    
+    reply(tracker, Fast, Tracker::DecayThreshold);
+    CHECK(near(tracker.health(PID).p50, LatencyHistogram::bucketLimit(1)));
+    
+    // Without decay, the 256 fast samples would outnumber these 200 slow ones. With it,
+    // they are halved on the first slow sample and again at the threshold, leaving 64.
+    reply(tracker, Slow, 200);
+    CHECK(near(tracker.health(PID).p50, LatencyHistogram::bucketLimit(6)));
+    
+    LatencyHistogram histogram;
+    
+    for(int i = 0; i < 5; ++i)
+        histogram.add(Fast);
+    
+    histogram.add(Slow);
+    histogram.decay();
+    CHECK_EQ(histogram.count(), (uint32_t)2);
+    CHECK(near(histogram.percentile(1.0), LatencyHistogram::bucketLimit(1)));
+}
+
+int main()
+{
+    testDefaultTimeout();
+    testTimeoutClamp();
+    testTimeoutsNotSampled();
+    testCircuit();
+    testProbing();
+    testDecay();
+    
+    return TEST_RESULT();
+}
@@ -0,0 +1,277 @@
+/*---------------------------------------------------------------------------------------------
+ *  Copyright (c) Nicolas Jinchereau. All rights reserved.
+ *  Licensed under the MIT License. See License.txt in the project root for license information.
+ *--------------------------------------------------------------------------------------------*/
+
+#include <test/Test.h>
+#include <ax/Snapshot.h>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+
+using namespace ax;
+
+static Snapshot sample()
+{
+    Snapshot snapshot;
+    
+    SnapshotEntry a;
+    a.bundleID = "com.apple.Safari";
+    a.title = "Caf\xC3\xA9 \xE6\x97\xA5\xE6\x9C\xAC \xF0\x9F\x98\x80";
+    a.iconPath = "/tmp/icons/com.apple.Safari.png";
+    a.focused = true;
+    snapshot.entries.push_back(a);
+    
+    // all strings empty
+    snapshot.entries.push_back(SnapshotEntry());
+    
+    SnapshotEntry c;
+    c.bundleID = "com.example.editor";
+    c.title = string(300, 'x');
+    snapshot.entries.push_back(c);
+    
+    return snapshot;
+}
+
+static bool parse(const vector<uint8_t>& data)
+{
+    Snapshot out;
+    return Snapshot::deserialize(data.data(), data.size(), out);
+}
+
+static void put32(vector<uint8_t>& data, size_t offset, uint32_t value)
+{
+    for(int i = 0; i < 4; ++i)
+        data[offset + i] = (uint8_t)(value >> (i * 8));
+}
+
+static void testRoundTrip()
+{
+    Snapshot snapshot = sample();
+    vector<uint8_t> data = snapshot.serialize();
+    
+    Snapshot out;
+    CHECK(Snapshot::deserialize(data.data(), data.size(), out));
+    CHECK(out == snapshot);
+    CHECK(out.entries[0].focused);
+    CHECK(!out.entries[1].focused);
+    
+    // an empty snapshot is just the header
+    Snapshot empty;
+    vector<uint8_t> emptyData = empty.serialize();
+    CHECK_EQ(emptyData.size(), Snapshot::HeaderSize);
+    
+    out = snapshot;
+    CHECK(Snapshot::deserialize(emptyData.data(), emptyData.size(), out));
+    CHECK(out.entries.empty());
+}
+
+static void testCorruption()
+{
+    vector<uint8_t> good = sample().serialize();
+    CHECK(parse(good));
+    
+    // any flipped payload byte fails the crc
+    for(size_t i = Snapshot::HeaderSize; i < good.size(); i += 7)
+    {
+        vector<uint8_t> data = good;
+        data[i] ^= 0x40;
+        CHECK(!parse(data));
+    }
+    
+    // wrong magic
+    vector<uint8_t> data = good;
+    data[0] ^= 0xFF;
+    CHECK(!parse(data));
+    
+    // wrong version
+    data = good;
+    data[4] = (uint8_t)(Snapshot::Version + 1);
+    CHECK(!parse(data));
+    
+    // reserved field set
+    data = good;
+    data[6] = 1;
+    CHECK(!parse(data));
+}
+
+static void testTruncation()
+{
+    vector<uint8_t> good = sample().serialize();
+    
+    for(size_t size = 0; size < good.size(); ++size)
+    {
+        Snapshot out;
+        CHECK(!Snapshot::deserialize(good.data(), size, out));
+    }
+    
+    // trailing garbage is rejected too
+    vector<uint8_t> data = good;
+    data.push_back(0);
+    CHECK(!parse(data));
+}
+
+static void testCount()
+{
+    vector<uint8_t> good = sample().serialize();
+    
+    // more entries than the payload could hold, which must not be reserved
+    vector<uint8_t> data = good;
+    put32(data, 8, 0xFFFFFFFF);
+    CHECK(!parse(data));
+    
+    // one more entry than was written
+    data = good;
+    put32(data, 8, 4);
+    CHECK(!parse(data));
+    
+    // one less leaves unread payload
+    data = good;
+    put32(data, 8, 2);
+    CHECK(!parse(data));
+}
+
+static void testSaveLoad()
+{
+    char dir[] = "/tmp/snapshot-test-XXXXXX";
+    if(!mkdtemp(dir))
+    {
+        CHECK(!"mkdtemp failed");
+        return;
+    }
+    
+    string path = string(dir) + "/layout.snapshot";
+    Snapshot snapshot = sample();
+    
+    Snapshot out;
+    CHECK(!Snapshot::load(path, out));
+    
+    CHECK(snapshot.save(path));
+    CHECK(Snapshot::load(path, out));
+    CHECK(out == snapshot);
+    
+    // saving again replaces the file, and leaves no temporary behind
+    snapshot.entries.pop_back();
+    CHECK(snapshot.save(path));
+    CHECK(Snapshot::load(path, out));
+    CHECK(out == snapshot);
+    CHECK(access((path + ".tmp").c_str(), F_OK) != 0);
+    
+    // a file cut short fails to load
+    CHECK(truncate(path.c_str(), Snapshot::HeaderSize + 3) == 0);
+    CHECK(!Snapshot::load(path, out));
+    
+    remove(path.c_str());
+    rmdir(dir);
+}
+
+static SnapshotEntry entry(const string& bundleID, const string& title)
+{
+    SnapshotEntry ret;
+    ret.bundleID = bundleID;
+    ret.title = title;
+    return ret;
+}
+
+static void testReconcileExactMatch()
+{
+    Snapshot snapshot;
+    snapshot.entries.push_back(entry("com.apple.Safari", "Apple"));
+    snapshot.entries.push_back(entry("com.apple.Safari", "GitHub"));
+    
+    // an exact title wins over an earlier entry of the same app
+    SnapshotReconciler reconciler(snapshot);
+    CHECK_EQ(reconciler.claim("com.apple.Safari", "GitHub"), 1);
+    CHECK(reconciler.isClaimed(1));
+    CHECK(!reconciler.isClaimed(0));
+    CHECK_EQ(reconciler.claim("com.apple.Safari", "Apple"), 0);
+    CHECK(reconciler.unclaimed().empty());
+}
+
+static void testReconcileRename()
+{
+    Snapshot snapshot;
+    snapshot.entries.push_back(entry("com.apple.Terminal", "bash"));
+    snapshot.entries.push_back(entry("com.apple.Safari", "Apple"));
+    snapshot.entries.push_back(entry("com.apple.Terminal", "vim"));
+    
+    // a renamed window takes the first unclaimed entry of its app
+    SnapshotReconciler reconciler(snapshot);
+    CHECK_EQ(reconciler.claim("com.apple.Terminal", "zsh"), 0);
+    CHECK_EQ(reconciler.claim("com.apple.Terminal", "top"), 2);
+    CHECK_EQ(reconciler.claim("com.apple.Terminal", "less"), -1);
+    CHECK(!reconciler.isClaimed(1));
+}
+
+static void testReconcileOtherApp()
+{
+    Snapshot snapshot;
+    snapshot.entries.push_back(entry("com.apple.Safari", "Notes"));
+    
+    // an entry is never claimed by another app, even with the same title
+    SnapshotReconciler reconciler(snapshot);
+    CHECK_EQ(reconciler.claim("com.apple.Notes", "Notes"), -1);
+    CHECK_EQ(reconciler.claim("", ""), -1);
+    CHECK(!reconciler.isClaimed(0));
+    CHECK_EQ(reconciler.unclaimed().size(), (size_t)1);
+    
+    SnapshotReconciler empty;
+    CHECK_EQ(empty.claim("com.apple.Safari", "Notes"), -1);
+    CHECK_EQ(empty.size(), (size_t)0);
+}
+
+static void testReconcileDuplicates()
+{
+    Snapshot snapshot;
+    snapshot.entries.push_back(entry("com.apple.finder", "Downloads"));
+    snapshot.entries.push_back(entry("com.apple.finder", "Documents"));
+    snapshot.entries.push_back(entry("com.apple.finder", "Downloads"));
+    
+    // duplicate titles are claimed one at a time, in order
+    SnapshotReconciler reconciler(snapshot);
+    CHECK_EQ(reconciler.claim("com.apple.finder", "Downloads"), 0);
+    CHECK_EQ(reconciler.claim("com.apple.finder", "Downloads"), 2);
+    
+    // with both taken, a third falls back to the remaining entry of the app
+    CHECK_EQ(reconciler.claim("com.apple.finder", "Downloads"), 1);
+    CHECK_EQ(reconciler.claim("com.apple.finder", "Downloads"), -1);
+}
+
+static void testReconcileUnclaimed()
+{
+    Snapshot snapshot;
+    snapshot.entries.push_back(entry("com.apple.Safari", "Apple"));
+    snapshot.entries.push_back(entry("com.apple.Mail", "Inbox"));
+    snapshot.entries.push_back(entry("com.apple.Safari", "GitHub"));
+    snapshot.entries.push_back(entry("com.apple.Notes", "Notes"));
+    snapshot.entries.push_back(entry("com.apple.Mail", "Drafts"));
+    
+    SnapshotReconciler reconciler(snapshot);
+    CHECK_EQ(reconciler.size(), (size_t)5);
+    CHECK_EQ(reconciler.unclaimed().size(), (size_t)5);
+    
+    reconciler.claim("com.apple.Safari", "GitHub");
+    reconciler.claim("com.apple.Mail", "Inbox");
+    
+    // exactly the leftovers, in snapshot order
+    vector<size_t> expected = { 0, 3, 4 };
+    CHECK(reconciler.unclaimed() == expected);
+    
+    CHECK(!reconciler.isClaimed(5));
+}
+
+int main()
+{
+    testRoundTrip();
+    testCorruption();
+    testTruncation();
+    testCount();
+    testSaveLoad();
+    testReconcileExactMatch();
+    testReconcileRename();
+    testReconcileOtherApp();
+    testReconcileDuplicates();
+    testReconcileUnclaimed();
+    
+    return TEST_RESULT();
+}
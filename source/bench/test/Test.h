@@ -0,0 +1,35 @@
+/*---------------------------------------------------------------------------------------------
+ *  Copyright (c) Nicolas Jinchereau. All rights reserved.
+ *  Licensed under the MIT License. See License.txt in the project root for license information.
+ *--------------------------------------------------------------------------------------------*/
+
+#pragma once
+#include <iostream>
+#include <string>
+using namespace std;
+
+// Minimal checks for the Cocoa-free tests. A failed check is reported and
+// counted, and TEST_RESULT() makes the process exit non-zero so ctest fails.
+
+static int _testFailures = 0;
+
+#define CHECK(cond)                                                             \
+    do {                                                                        \
+        if(!(cond)) {                                                           \
+            cout << __FILE__ << ":" << __LINE__ << ": check failed: " #cond << endl; \
+            ++_testFailures;                                                    \
+        }                                                                       \
+    } while(0)
+
+#define CHECK_EQ(a, b)                                                          \
+    do {                                                                        \
+        auto _a = (a);                                                          \
+        auto _b = (b);                                                          \
+        if(!(_a == _b)) {                                                       \
+            cout << __FILE__ << ":" << __LINE__ << ": check failed: " #a " == " #b \
+                 << " (" << _a << " vs " << _b << ")" << endl;                  \
+            ++_testFailures;                                                    \
+        }                                                                       \
+    } while(0)
+
+#define TEST_RESULT() (_testFailures == 0 ? 0 : 1)
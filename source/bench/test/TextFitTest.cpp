@@ -0,0 +1,145 @@
+/*---------------------------------------------------------------------------------------------
+ *  Copyright (c) Nicolas Jinchereau. All rights reserved.
+ *  Licensed under the MIT License. See License.txt in the project root for license information.
+ *--------------------------------------------------------------------------------------------*/
+
+#include <test/Test.h>
+#include <ui/TextFit.h>
+
+static const char *ELLIPSIS = "\xE2\x80\xA6";
+
+// every codepoint, including the ellipsis, is 8 wide, which is a multiple of the bucket size
+static FixedAdvanceMetrics metrics("Fixed-8", 8.0f);
+
+static void testEviction()
+{
+    TextFitCache cache(2);
+    
+    auto a = cache.measure("a", metrics);
+    cache.measure("b", metrics);
+    CHECK_EQ(cache.misses(), 2u);
+    CHECK_EQ(cache.hits(), 0u);
+    
+    // touching "a" makes "b" the least recently used
+    CHECK(cache.measure("a", metrics) == a);
+    CHECK_EQ(cache.hits(), 1u);
+    
+    cache.measure("c", metrics);
+    CHECK_EQ(cache.evictions(), 1u);
+    CHECK_EQ(cache.size(), 2u);
+    
+    // "a" survived, "b" was evicted
+    CHECK(cache.measure("a", metrics) == a);
+    CHECK_EQ(cache.hits(), 2u);
+    
+    cache.measure("b", metrics);
+    CHECK_EQ(cache.misses(), 4u);
+    CHECK_EQ(cache.evictions(), 2u);
+    
+    // the same title in another font is another entry
+    FixedAdvanceMetrics other("Fixed-12", 12.0f);
+    auto b12 = cache.measure("b", other);
+    CHECK_EQ(b12->width(), 12.0f);
+    CHECK_EQ(cache.misses(), 5u);
+    
+    // evicted handles stay valid
+    CHECK_EQ(a->text(), string("a"));
+}
+
+static void testMaxFits()
+{
+    TextRun run(string(1000, 'x'), metrics);
+    
+    for(size_t i = 0; i < TextRun::MaxFits; ++i)
+        run.fit((float)i * TextRun::BucketSize);
+    
+    CHECK_EQ(run.fitCount(), TextRun::MaxFits);
+    
+    // widths within a bucket share one fit
+    uint64_t serial = run.fit(8.0f).serial;
+    CHECK_EQ(run.fit(8.0f + TextRun::BucketSize - 0.5f).serial, serial);
+    CHECK_EQ(run.fitCount(), TextRun::MaxFits);
+    
+    // one more bucket drops all the others
+    run.fit(TextRun::MaxFits * TextRun::BucketSize);
+    CHECK_EQ(run.fitCount(), 1u);
+    
+    // the full text is never cached as a fit
+    CHECK(!run.fit(run.width()).truncated);
+    CHECK_EQ(run.fitCount(), 1u);
+}
+
+static void testTrailingWhitespace()
+{
+    TextRun run("ab   cd", metrics);
+    
+    // room for "ab  " and the ellipsis, but the spaces are trimmed
+    const TextFit &fit = run.fit(40.0f);
+    CHECK(fit.truncated);
+    CHECK_EQ(fit.text, string("ab") + ELLIPSIS);
+    CHECK_EQ(fit.width, 24.0f);
+    
+    // all whitespace before the cut leaves only the ellipsis
+    TextRun spaces("   x", metrics);
+    CHECK_EQ(spaces.fit(24.0f).text, string(ELLIPSIS));
+}
+
+static void testMultiByte()
+{
+    // 2, 3 and 4 byte codepoints
+    string text = "\xC3\xA9\xE6\x97\xA5\xF0\x9F\x98\x80zz";
+    TextRun run(text, metrics);
+    CHECK_EQ(run.width(), 40.0f);
+    
+    const char *prefixes[] = { "", "\xC3\xA9", "\xC3\xA9\xE6\x97\xA5", "\xC3\xA9\xE6\x97\xA5\xF0\x9F\x98\x80" };
+    
+    for(int n = 1; n <= 3; ++n)
+    {
+        const TextFit &fit = run.fit((float)(n + 1) * 8.0f);
+        CHECK_EQ(fit.text, string(prefixes[n]) + ELLIPSIS);
+    }
+    
+    // every width in between cuts on a codepoint boundary
+    for(float w = 0; w < 40.0f; w += 1.0f)
+    {
+        string fit = run.fit(w).text;
+        size_t i = 0;
+        while(i < fit.size())
+        {
+            uint32_t cp = decode_utf8(fit, i);
+            CHECK(cp != 0xFFFD);
+        }
+    }
+    
+    // invalid bytes decode as replacement characters, one at a time
+    string bad = "\xE6\x97";
+    size_t i = 0;
+    CHECK_EQ(decode_utf8(bad, i), 0xFFFDu);
+}
+
+static void testNarrowerThanEllipsis()
+{
+    TextRun run("abcdef", metrics);
+    
+    const TextFit &fit = run.fit(7.0f);
+    CHECK(fit.truncated);
+    CHECK(fit.text.empty());
+    CHECK_EQ(fit.width, 0.0f);
+    
+    CHECK(run.fit(0.0f).text.empty());
+    CHECK(run.fit(-20.0f).text.empty());
+    
+    // exactly the ellipsis
+    CHECK_EQ(run.fit(8.0f).text, string(ELLIPSIS));
+}
+
+int main()
+{
+    testEviction();
+    testMaxFits();
+    testTrailingWhitespace();
+    testMultiByte();
+    testNarrowerThanEllipsis();
+    
+    return TEST_RESULT();
+}
@@ -6,6 +6,7 @@
 #import <Cocoa/Cocoa.h>
 #include <memory>
 #include <ax/AXWorkspace.h>
+#include <ax/Snapshot.h>
 
 @class TaskBarWindow;
 @interface Workspace : AXWorkspace
@@ -19,6 +20,10 @@
 @interface AppDelegate : NSObject<NSApplicationDelegate>
 {
     Workspace* _workspace;
+    TaskBarWindow* _taskbar;
+    NSTimer* _snapshotTimer;
+    NSTimeInterval _placeholderDeadline;
+    ax::Snapshot _lastSnapshot;
 }
 
 @end
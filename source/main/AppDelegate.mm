@@ -7,6 +7,12 @@
 #include <ui/TaskBarWindow.h>
 #import <Cocoa/Cocoa.h>
 
+#define SNAPSHOT_INTERVAL 30.0
+
+// how long snapshot buttons wait for slow or unresponsive apps to be enumerated
+#define PLACEHOLDER_TIMEOUT 5.0
+#define PLACEHOLDER_CHECK_INTERVAL 0.25
+
 @implementation Workspace
 -(void)applicationCreated:(ax::Application*)app
 {
@@ -63,12 +69,88 @@
 {
     [AXWorkspace assertAccessibilityEnabled];
     
-    TaskBarWindow* taskbar = [[[TaskBarWindow alloc] init] autorelease];
-    _workspace = [[Workspace alloc] initWithTaskbar:taskbar];
+    _taskbar = [[TaskBarWindow alloc] init];
+    
+    // paint the last known layout before enumerating applications
+    if(ax::Snapshot::load([[self snapshotPath] UTF8String], _lastSnapshot))
+    {
+        [_taskbar restoreSnapshot:_lastSnapshot];
+        [_taskbar display];
+    }
+    
+    [self performSelector:@selector(startWorkspace) withObject:nil afterDelay:0];
+}
+
+-(void)startWorkspace
+{
+    // live windows claim the snapshot's buttons as they're enumerated
+    _workspace = [[Workspace alloc] initWithTaskbar:_taskbar];
+    
+    _placeholderDeadline = [NSDate timeIntervalSinceReferenceDate] + PLACEHOLDER_TIMEOUT;
+    [self dropPlaceholdersWhenSettled];
+    
+    _snapshotTimer = [NSTimer scheduledTimerWithTimeInterval:SNAPSHOT_INTERVAL
+                                                      target:self
+                                                    selector:@selector(saveSnapshot)
+                                                    userInfo:nil
+                                                     repeats:YES];
+}
+
+// Apps that are still pending, or behind an open circuit, are enumerated by the
+// workspace's retry pass. Their placeholders are kept until no retry is pending,
+// so that they don't collapse now just to animate back in on the next retry.
+-(void)dropPlaceholdersWhenSettled
+{
+    if([_workspace needsUpdate] && [NSDate timeIntervalSinceReferenceDate] < _placeholderDeadline)
+    {
+        [self performSelector:@selector(dropPlaceholdersWhenSettled) withObject:nil afterDelay:PLACEHOLDER_CHECK_INTERVAL];
+        return;
+    }
+    
+    [_taskbar dropPlaceholders];
+}
+
+-(NSString*)cacheDirectory
+{
+    NSString *caches = [NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES) firstObject];
+    NSString *dir = [caches stringByAppendingPathComponent:[[NSBundle mainBundle] bundleIdentifier]];
+    
+    NSString *iconDir = [dir stringByAppendingPathComponent:@"icons"];
+    [[NSFileManager defaultManager] createDirectoryAtPath:iconDir withIntermediateDirectories:YES attributes:nil error:nil];
+    
+    return dir;
+}
+
+-(NSString*)snapshotPath
+{
+    return [[self cacheDirectory] stringByAppendingPathComponent:@"layout.snapshot"];
+}
+
+-(void)saveSnapshot
+{
+    NSString *iconDir = [[self cacheDirectory] stringByAppendingPathComponent:@"icons"];
+    ax::Snapshot snapshot = [_taskbar snapshotWithIconDirectory:iconDir];
+    
+    if(snapshot != _lastSnapshot)
+    {
+        if(snapshot.save([[self snapshotPath] UTF8String]))
+            _lastSnapshot = move(snapshot);
+        else
+            cout << "failed to save taskbar snapshot" << endl;
+    }
 }
 
 - (void)applicationWillTerminate:(NSNotification*)aNotification
 {
+    [NSObject cancelPreviousPerformRequestsWithTarget:self];
+    [_snapshotTimer invalidate];
+    [self saveSnapshot];
+    
+#if DEBUG
+    [_workspace logStats];
+#endif
+    
     [_workspace release];
+    [_taskbar release];
 }
 @end
@@ -12,6 +12,8 @@
 #include <QuartzCore/CVDisplayLink.h>
 #include <CoreVideo/CoreVideo.h>
 #include <ui/Utils.h>
+#include <ui/TextFit.h>
+#include <memory>
 using namespace std;
 
 struct WindowInfo;
@@ -27,6 +29,11 @@ struct WindowInfo;
     NSGradient* _hotGradient;
     NSGradient* _selectedGradient;
     NSGradient* _pressedGradient;
+    
+    // title measured once, and the string last drawn for it
+    shared_ptr<TextRun> _titleRun;
+    uint64_t _fitSerial;
+    NSString *_fitText;
 }
 -(void)setHotImage:(NSImage*)image;
 @end
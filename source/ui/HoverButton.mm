@@ -5,6 +5,81 @@
 
 #include <ui/HoverButton.h>
 #include <ax/AXWorkspace.h>
+#include <CoreText/CoreText.h>
+
+// Font metrics from CoreText, cached per codepoint.
+class CTFontMetrics : public FontMetrics
+{
+public:
+    CTFontMetrics(NSFont *font, const string& fontKey)
+        : _font([font retain]),
+          _fontKey(fontKey)
+    {
+    }
+    
+    ~CTFontMetrics() {
+        [_font release];
+    }
+    
+    virtual const string& fontKey() const override {
+        return _fontKey;
+    }
+    
+    virtual float advance(uint32_t codepoint) const override
+    {
+        auto it = _advances.find(codepoint);
+        if(it != _advances.end())
+            return it->second;
+        
+        UniChar chars[2];
+        CFIndex count = CFStringGetSurrogatePairForLongCharacter(codepoint, chars) ? 2 : 1;
+        if(count == 1)
+            chars[0] = (UniChar)codepoint;
+        
+        CGGlyph glyphs[2] = { 0, 0 };
+        CGSize advances[2];
+        float ret;
+        
+        if(CTFontGetGlyphsForCharacters((CTFontRef)_font, chars, glyphs, count))
+        {
+            CTFontGetAdvancesForGlyphs((CTFontRef)_font, kCTFontDefaultOrientation, glyphs, advances, 1);
+            ret = advances[0].width;
+        }
+        else
+        {
+            // not in this font - let AppKit measure it with its fallback font
+            NSString *str = [NSString stringWithCharacters:chars length:count];
+            ret = [str sizeWithAttributes:@{ NSFontAttributeName : _font }].width;
+        }
+        
+        _advances[codepoint] = ret;
+        return ret;
+    }
+    
+private:
+    NSFont *_font;
+    string _fontKey;
+    mutable unordered_map<uint32_t, float> _advances;
+};
+
+static FontMetrics& metricsForFont(NSFont *font)
+{
+    static unordered_map<string, unique_ptr<CTFontMetrics>> metrics;
+    
+    string key = string([[font fontName] UTF8String]) + "-" + to_string([font pointSize]);
+    
+    auto& ret = metrics[key];
+    if(!ret)
+        ret.reset(new CTFontMetrics(font, key));
+    
+    return *ret;
+}
+
+static TextFitCache& titleCache()
+{
+    static TextFitCache cache;
+    return cache;
+}
 
 @implementation HoverButtonCell
 
@@ -18,6 +93,8 @@
         _focused = false;
         _down = false;
         _hotImage = nil;
+        _fitSerial = 0;
+        _fitText = nil;
         
         NSColor* _hotGradStart = [NSColor colorWithRed:(165 / 255.0f) green:(227 / 255.0f) blue:(254 / 255.0f) alpha:1.0f];
         NSColor* _hotGradEnd = [NSColor colorWithRed:(44 / 255.0f) green:(182 / 255.0f) blue:(255 / 255.0f) alpha:1.0f];
@@ -51,6 +128,7 @@
     [_hotGradient release];
     [_selectedGradient release];
     [_pressedGradient release];
+    [_fitText release];
     [super dealloc];
 }
 
@@ -60,6 +138,40 @@
     _hotImage = [image retain];
 }
 
+- (void)setTitle:(NSString*)title
+{
+    [super setTitle:title];
+    _titleRun = nullptr;
+}
+
+// the font the title is drawn with (attributed strings default to Helvetica 12)
+- (NSFont*)textFont
+{
+    NSFont *font = [textAttributes objectForKey:NSFontAttributeName];
+    return font ? font : [NSFont fontWithName:@"Helvetica" size:12];
+}
+
+// returns the title truncated to 'width', measuring it only when the title changes
+- (NSString*)fittedTitle:(CGFloat)width
+{
+    if(!_titleRun)
+    {
+        const char *title = [self.title UTF8String];
+        _titleRun = titleCache().measure(title ? title : "", metricsForFont([self textFont]));
+    }
+    
+    const TextFit& fit = _titleRun->fit((float)width);
+    
+    if(fit.serial != _fitSerial)
+    {
+        [_fitText release];
+        _fitText = [[NSString alloc] initWithUTF8String:fit.text.c_str()];
+        _fitSerial = fit.serial;
+    }
+    
+    return _fitText;
+}
+
 - (void)drawWithFrame:(NSRect)cellFrame inView:(NSView*)controlView
 {
     ////////////////
@@ -130,7 +242,7 @@
     textRect.size.width -= [image size].width + 10;
     textRect.origin.y = (textRect.size.height - [self font].pointSize) * 0.5f;
     
-    [self.title drawInRect:textRect withAttributes:textAttributes];
+    [[self fittedTitle:textRect.size.width] drawInRect:textRect withAttributes:textAttributes];
 }
 
 @end
@@ -15,6 +15,7 @@
 #include <memory>
 #include <unordered_map>
 #include <ax/AXWorkspace.h>
+#include <ax/Snapshot.h>
 using namespace std;
 
 class WindowInfo;
@@ -30,6 +31,10 @@ class WindowInfo;
     
     std::vector<std::shared_ptr<WindowInfo>> _windows;
     
+    // buttons painted from the last snapshot, by snapshot index, until claimed by live windows
+    std::vector<std::shared_ptr<WindowInfo>> _placeholders;
+    ax::SnapshotReconciler _reconciler;
+    
     id _mouseEventMonitor;
 }
 
@@ -46,6 +51,10 @@ class WindowInfo;
 -(void)renameWindow:(ax::Window*)window;
 -(void)setWindowFocus:(ax::Window*)window focused:(bool)focused;
 
+-(void)restoreSnapshot:(const ax::Snapshot&)snapshot;
+-(void)dropPlaceholders;
+-(ax::Snapshot)snapshotWithIconDirectory:(NSString*)iconDirectory;
+
 -(void)globalLeftMouseDown;
 -(void)globalLeftMouseUp;
 @end
@@ -6,18 +6,14 @@
 #include <ui/TaskBarWindow.h>
 #include <ui/AppleButton.h>
 #include <ui/MenuHelpers.h>
+#include <ui/Utils.h>
+#include <ui/TaskLayout.h>
 #include <Cocoa/Cocoa.h>
 #include <AppKit/AppKit.h>
 #include <algorithm>
 
-#define TB_HEIGHT                   32
-#define START_BTN_WIDTH             64
-#define START_BTN_HEIGHT            32
-#define START_BTN_RIGHT_SPACING     4
-#define BUTTON_SIZE                 200
-#define BUTTON_SPACING              1
 #define UPDATE_RATE                 0.1f
-#define BUTTON_EXPAND_SPEED         3.0f
+#define SNAPSHOT_ICON_SIZE          64
 
 CVReturn RenderTaskBarButtons(CVDisplayLinkRef displayLink,
                               const CVTimeStamp *inNow,
@@ -34,7 +30,19 @@ CVReturn RenderTaskBarButtons(CVDisplayLinkRef displayLink,
 class WindowInfo
 {
 public:
-    WindowInfo(){}
+    WindowInfo()
+        : app(nil),
+          window(nullptr),
+          processId(0),
+          icon(nil),
+          button(nil),
+          currentWidth(0),
+          keep(false),
+          updateTitle(false),
+          unsupported(false),
+          placeholder(false)
+    {
+    }
     
     ~WindowInfo() {
         [icon release];
@@ -44,6 +52,7 @@ public:
     NSRunningApplication *app;
     ax::Window* window;
     uint64_t processId;
+    string bundleID;
     string title;
     NSImage *icon;
     HoverButton *button;
@@ -51,6 +60,9 @@ public:
     bool keep;
     bool updateTitle;
     bool unsupported;
+    
+    // painted from a snapshot, and not yet bound to a live window
+    bool placeholder;
 };
 
 @implementation TaskBarWindow
@@ -170,13 +182,9 @@ public:
 {
     float deltaTime = (float)(CACurrentMediaTime() - lastRender);
     
-    float usedWidth = BUTTON_SPACING + START_BTN_WIDTH + START_BTN_RIGHT_SPACING;
-    usedWidth += (float)(max((int)_windows.size() - 1, 0)) * BUTTON_SPACING;
-    
-    float availableWidth = [self frame].size.width - usedWidth;
-    int maxButtonSize = (int)(availableWidth / (float)_windows.size());
-    
-    int windowButtonX = BUTTON_SPACING + START_BTN_WIDTH + START_BTN_RIGHT_SPACING;
+    const TaskLayout& layout = TaskLayout::taskbar();
+    int maxButtonSize = layout.maxButtonWidth([self frame].size.width, _windows.size());
+    int windowButtonX = (int)layout.origin();
     
     bool didUpdateButton = false;
     
@@ -185,30 +193,12 @@ public:
     {
         auto &info = (*it);
         
-        if(info->keep)
-        {
-            if(info->currentWidth < BUTTON_SIZE - 0.1f)
-            {
-                info->currentWidth = std::min(info->currentWidth
-                                   + BUTTON_SIZE * BUTTON_EXPAND_SPEED
-                                   * deltaTime, (float)BUTTON_SIZE);
-                didUpdateButton = true;
-            }
-        }
-        else
-        {
-            if(info->currentWidth > 0.1f)
-            {
-                info->currentWidth = max(info->currentWidth
-                                   - (float)BUTTON_SIZE * BUTTON_EXPAND_SPEED
-                                   * deltaTime, 0.0f);
-                didUpdateButton = true;
-            }
-        }
+        if(layout.animate(info->currentWidth, info->keep, deltaTime))
+            didUpdateButton = true;
         
-        if(info->currentWidth > 0.1f)
+        if(!layout.isCollapsed(info->currentWidth))
         {
-            int visibleWidth = min((int)info->currentWidth, maxButtonSize);
+            int visibleWidth = layout.visibleWidth(info->currentWidth, maxButtonSize);
             [info->button setFrame:NSMakeRect(windowButtonX, 0, visibleWidth, TB_HEIGHT)];
             windowButtonX += visibleWidth + BUTTON_SPACING;
             ++it;
@@ -254,28 +244,56 @@ public:
     if(!runningApp)
         return;
     
-    int windowButtonX = BUTTON_SPACING + START_BTN_WIDTH + START_BTN_RIGHT_SPACING;
-    
-    for(auto &info : _windows)
-        windowButtonX += info->currentWidth + BUTTON_SPACING;
+    // take over the button painted for this window from the last snapshot
+    int index = _reconciler.claim(window->app()->bundleID(), window->title());
+    if(index >= 0 && _placeholders[index])
+    {
+        auto info = _placeholders[index];
+        _placeholders[index] = nullptr;
+        [self bindWindow:window toInfo:info app:runningApp];
+        return;
+    }
     
     auto info = make_shared<WindowInfo>();
+    info->currentWidth = 0.5f;
+    
+    NSString *btnText = [NSString stringWithUTF8String:window->title().c_str()];
+    
+    info->button = [[HoverButton alloc] autorelease];
+    [info->button initWithFrame:NSMakeRect(0, 0, 0, 0) title:btnText];
+    
+    [self bindWindow:window toInfo:info app:runningApp];
+    
+    [[self contentView] addSubview: info->button];
+    
+    _windows.push_back(info);
+    
+    [self startAnimation];
+}
+
+-(void)bindWindow:(ax::Window*)window toInfo:(const shared_ptr<WindowInfo>&)info app:(NSRunningApplication*)runningApp
+{
+    [info->app release];
+    [info->icon release];
     
     info->app = [runningApp retain];
     info->window = window;
     info->processId = window->app()->processID();
+    info->bundleID = window->app()->bundleID();
     info->title = window->title();
     info->icon = [[runningApp icon] retain];
     info->keep = true;
     info->updateTitle = false;
     info->unsupported = false;
-    info->currentWidth = 0.5f;
+    info->placeholder = false;
     
     NSString *btnText = [NSString stringWithUTF8String:window->title().c_str()];
     
-    info->button = [[HoverButton alloc] autorelease];
-    [info->button initWithFrame:NSMakeRect(0, 0, 0, 0) title:btnText];
+    [info->button setTitle:btnText];
+    [info->button setToolTip:btnText];
     [info->button setImage:info->icon];
+    [info->button setFocused:NO];
+    info->button.isEnabled = YES;
     
     info->button.leftClickAction = [=](NSEvent *event)
     {
@@ -306,12 +324,6 @@ public:
     {
         window->focus();
     };
-    
-    [[self contentView] addSubview: info->button];
-    
-    _windows.push_back(info);
-    
-    [self startAnimation];
 }
 
 -(void)removeWindow:(ax::Window*)window
@@ -352,5 +364,90 @@ public:
         }
     }
 }
+
+-(void)restoreSnapshot:(const ax::Snapshot&)snapshot
+{
+    _reconciler = ax::SnapshotReconciler(snapshot);
+    _placeholders.clear();
+    
+    for(auto& entry : snapshot.entries)
+    {
+        auto info = make_shared<WindowInfo>();
+        info->bundleID = entry.bundleID;
+        info->title = entry.title;
+        info->keep = true;
+        info->placeholder = true;
+        info->currentWidth = BUTTON_SIZE;
+        
+        if(!entry.iconPath.empty())
+        {
+            NSString *iconPath = [NSString stringWithUTF8String:entry.iconPath.c_str()];
+            info->icon = [[NSImage alloc] initWithContentsOfFile:iconPath];
+        }
+        
+        NSString *btnText = [NSString stringWithUTF8String:entry.title.c_str()];
+        
+        info->button = [[HoverButton alloc] autorelease];
+        [info->button initWithFrame:NSMakeRect(0, 0, 0, 0) title:btnText];
+        [info->button setImage:info->icon];
+        [info->button setFocused:entry.focused];
+        info->button.isEnabled = NO;
+        
+        [[self contentView] addSubview: info->button];
+        
+        _windows.push_back(info);
+        _placeholders.push_back(info);
+    }
+    
+    // lay out the buttons right away, at full width
+    if(!_windows.empty())
+        [self updateAnimation];
+}
+
+-(void)dropPlaceholders
+{
+    for(auto& info : _placeholders)
+    {
+        if(info)
+            info->keep = false;
+    }
+    
+    _placeholders.clear();
+    _reconciler = ax::SnapshotReconciler();
+    
+    [self startAnimation];
+}
+
+-(ax::Snapshot)snapshotWithIconDirectory:(NSString*)iconDirectory
+{
+    ax::Snapshot ret;
+    
+    NSFileManager *fm = [NSFileManager defaultManager];
+    
+    for(auto& info : _windows)
+    {
+        if(!info->keep)
+            continue;
+        
+        ax::SnapshotEntry entry;
+        entry.bundleID = info->bundleID;
+        entry.title = info->title;
+        entry.focused = [info->button hoverButtonCell]->_focused;
+        
+        // icons are rasterized once per app, and reused by later snapshots
+        if(!info->bundleID.empty() && info->icon)
+        {
+            NSString *fileName = [[NSString stringWithUTF8String:info->bundleID.c_str()] stringByAppendingPathExtension:@"png"];
+            NSString *iconPath = [iconDirectory stringByAppendingPathComponent:fileName];
+            
+            if([fm fileExistsAtPath:iconPath] || [Utils writeIcon:info->icon toPNG:iconPath size:SNAPSHOT_ICON_SIZE])
+                entry.iconPath = [iconPath UTF8String];
+        }
+        
+        ret.entries.push_back(move(entry));
+    }
+    
+    return ret;
+}
 @end
 
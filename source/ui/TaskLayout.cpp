@@ -0,0 +1,82 @@
+/*---------------------------------------------------------------------------------------------
+ *  Copyright (c) Nicolas Jinchereau. All rights reserved.
+ *  Licensed under the MIT License. See License.txt in the project root for license information.
+ *--------------------------------------------------------------------------------------------*/
+
+#include <ui/TaskLayout.h>
+#include <algorithm>
+using namespace std;
+
+TaskLayout::TaskLayout(float origin, float spacing, float buttonSize, float expandSpeed)
+    : _origin(origin),
+      _spacing(spacing),
+      _buttonSize(buttonSize),
+      _expandSpeed(expandSpeed)
+{
+    
+}
+
+const TaskLayout& TaskLayout::taskbar()
+{
+    static TaskLayout layout(BUTTON_SPACING + START_BTN_WIDTH + START_BTN_RIGHT_SPACING,
+                             BUTTON_SPACING, BUTTON_SIZE, BUTTON_EXPAND_SPEED);
+    return layout;
+}
+
+float TaskLayout::origin() const
+{
+    return _origin;
+}
+
+float TaskLayout::spacing() const
+{
+    return _spacing;
+}
+
+float TaskLayout::buttonSize() const
+{
+    return _buttonSize;
+}
+
+int TaskLayout::maxButtonWidth(float barWidth, size_t count) const
+{
+    if(count == 0)
+        return (int)_buttonSize;
+    
+    float usedWidth = _origin + (float)(count - 1) * _spacing;
+    float availableWidth = barWidth - usedWidth;
+    
+    return (int)(availableWidth / (float)count);
+}
+
+bool TaskLayout::animate(float &currentWidth, bool keep, float deltaTime) const
+{
+    if(keep)
+    {
+        if(currentWidth < _buttonSize - 0.1f)
+        {
+            currentWidth = min(currentWidth + _buttonSize * _expandSpeed * deltaTime, _buttonSize);
+            return true;
+        }
+    }
+    else
+    {
+        if(currentWidth > 0.1f)
+        {
+            currentWidth = max(currentWidth - _buttonSize * _expandSpeed * deltaTime, 0.0f);
+            return true;
+        }
+    }
+    
+    return false;
+}
+
+int TaskLayout::visibleWidth(float currentWidth, int maxButtonWidth) const
+{
+    return min((int)currentWidth, maxButtonWidth);
+}
+
+bool TaskLayout::isCollapsed(float currentWidth) const
+{
+    return currentWidth <= 0.1f;
+}
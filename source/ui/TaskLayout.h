@@ -0,0 +1,50 @@
+/*---------------------------------------------------------------------------------------------
+ *  Copyright (c) Nicolas Jinchereau. All rights reserved.
+ *  Licensed under the MIT License. See License.txt in the project root for license information.
+ *--------------------------------------------------------------------------------------------*/
+
+#pragma once
+#include <cstdlib>
+
+#define TB_HEIGHT                   32
+#define START_BTN_WIDTH             64
+#define START_BTN_HEIGHT            32
+#define START_BTN_RIGHT_SPACING     4
+#define BUTTON_SIZE                 200
+#define BUTTON_SPACING              1
+#define BUTTON_EXPAND_SPEED         3.0f
+
+// Lays out window buttons left to right, after the start button, and
+// animates them between collapsed and full width as they are added or removed.
+class TaskLayout
+{
+public:
+    // 'origin' is the x of the first button, 'expandSpeed' is in full button widths per second
+    TaskLayout(float origin, float spacing, float buttonSize, float expandSpeed);
+    
+    // the layout of the taskbar's window buttons
+    static const TaskLayout& taskbar();
+    
+    float origin() const;
+    float spacing() const;
+    float buttonSize() const;
+    
+    // the widest a button may be when 'count' buttons share a bar 'barWidth' wide
+    int maxButtonWidth(float barWidth, size_t count) const;
+    
+    // Moves 'currentWidth' toward full width if 'keep' is set, or toward zero otherwise.
+    // Returns true if the width changed, ie. the button is still animating.
+    bool animate(float &currentWidth, bool keep, float deltaTime) const;
+    
+    // width of the button's frame, clamped to 'maxButtonWidth'
+    int visibleWidth(float currentWidth, int maxButtonWidth) const;
+    
+    // true once a removed button has collapsed, and can be taken out of the layout
+    bool isCollapsed(float currentWidth) const;
+
+private:
+    float _origin;
+    float _spacing;
+    float _buttonSize;
+    float _expandSpeed;
+};
@@ -0,0 +1,248 @@
+/*---------------------------------------------------------------------------------------------
+ *  Copyright (c) Nicolas Jinchereau. All rights reserved.
+ *  Licensed under the MIT License. See License.txt in the project root for license information.
+ *--------------------------------------------------------------------------------------------*/
+
+#include <ui/TextFit.h>
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+
+static const uint32_t ELLIPSIS = 0x2026;
+static const char *ELLIPSIS_UTF8 = "\xE2\x80\xA6";
+
+uint32_t decode_utf8(const string& str, size_t& i)
+{
+    unsigned char c = (unsigned char)str[i++];
+    
+    if(c < 0x80)
+        return c;
+    
+    int extra = 0;
+    uint32_t cp = 0;
+    
+    if((c & 0xE0) == 0xC0) { extra = 1; cp = c & 0x1F; }
+    else if((c & 0xF0) == 0xE0) { extra = 2; cp = c & 0x0F; }
+    else if((c & 0xF8) == 0xF0) { extra = 3; cp = c & 0x07; }
+    else return 0xFFFD;
+    
+    for(int n = 0; n < extra; ++n)
+    {
+        if(i >= str.size() || ((unsigned char)str[i] & 0xC0) != 0x80)
+            return 0xFFFD;
+        
+        cp = (cp << 6) | ((unsigned char)str[i++] & 0x3F);
+    }
+    
+    return cp;
+}
+
+////////////////
+// FixedAdvanceMetrics
+
+FixedAdvanceMetrics::FixedAdvanceMetrics(const string& fontKey, float defaultAdvance)
+    : _fontKey(fontKey), _defaultAdvance(defaultAdvance)
+{
+    
+}
+
+void FixedAdvanceMetrics::setAdvance(uint32_t codepoint, float advance)
+{
+    _advances[codepoint] = advance;
+}
+
+const string& FixedAdvanceMetrics::fontKey() const
+{
+    return _fontKey;
+}
+
+float FixedAdvanceMetrics::advance(uint32_t codepoint) const
+{
+    auto it = _advances.find(codepoint);
+    return it != _advances.end() ? it->second : _defaultAdvance;
+}
+
+////////////////
+// TextRun
+
+constexpr float TextRun::BucketSize;
+constexpr size_t TextRun::MaxFits;
+
+static uint64_t _nextFitSerial()
+{
+    static uint64_t serial = 0;
+    return ++serial;
+}
+
+float TextRun::ellipsisAdvance(const FontMetrics& metrics)
+{
+    return metrics.advance(ELLIPSIS);
+}
+
+TextRun::TextRun(const string& text, const FontMetrics& metrics)
+    : _text(text),
+      _fontKey(metrics.fontKey()),
+      _ellipsisWidth(ellipsisAdvance(metrics))
+{
+    float x = 0;
+    
+    for(size_t i = 0; i < _text.size(); )
+    {
+        x += metrics.advance(decode_utf8(_text, i));
+        _offsets.push_back((uint32_t)i);
+        _advances.push_back(x);
+    }
+    
+    _full.text = _text;
+    _full.width = x;
+    _full.truncated = false;
+    _full.serial = _nextFitSerial();
+}
+
+const string& TextRun::text() const
+{
+    return _text;
+}
+
+const string& TextRun::fontKey() const
+{
+    return _fontKey;
+}
+
+float TextRun::width() const
+{
+    return _full.width;
+}
+
+size_t TextRun::fitCount() const
+{
+    return _fits.size();
+}
+
+const TextFit& TextRun::fit(float width)
+{
+    if(width >= _full.width)
+        return _full;
+    
+    int bucket = max((int)floor(width / BucketSize), 0);
+    
+    auto it = _fits.find(bucket);
+    if(it != _fits.end())
+        return it->second;
+    
+    if(_fits.size() >= MaxFits)
+        _fits.clear();
+    
+    TextFit& ret = _fits[bucket];
+    ret = _computeFit(bucket * BucketSize);
+    return ret;
+}
+
+TextFit TextRun::_computeFit(float width) const
+{
+    TextFit ret;
+    ret.serial = _nextFitSerial();
+    
+    if(width >= _full.width)
+    {
+        ret.text = _text;
+        ret.width = _full.width;
+        return ret;
+    }
+    
+    ret.truncated = true;
+    
+    // number of leading codepoints that fit alongside the ellipsis
+    float room = width - _ellipsisWidth;
+    size_t count = upper_bound(_advances.begin(), _advances.end(), room) - _advances.begin();
+    
+    // don't leave whitespace dangling before the ellipsis
+    while(count > 0 && isspace((unsigned char)_text[_offsets[count - 1] - 1]))
+        --count;
+    
+    if(count == 0)
+    {
+        ret.width = (_ellipsisWidth <= width) ? _ellipsisWidth : 0;
+        if(ret.width > 0)
+            ret.text = ELLIPSIS_UTF8;
+        return ret;
+    }
+    
+    ret.text.reserve(_offsets[count - 1] + 3);
+    ret.text.assign(_text, 0, _offsets[count - 1]);
+    ret.text += ELLIPSIS_UTF8;
+    ret.width = _advances[count - 1] + _ellipsisWidth;
+    
+    return ret;
+}
+
+////////////////
+// TextFitCache
+
+TextFitCache::TextFitCache(size_t capacity)
+    : _capacity(max(capacity, (size_t)1)),
+      _hits(0),
+      _misses(0),
+      _evictions(0)
+{
+    
+}
+
+shared_ptr<TextRun> TextFitCache::measure(const string& title, const FontMetrics& metrics)
+{
+    Key key{ title, metrics.fontKey() };
+    
+    auto it = _runs.find(key);
+    if(it != _runs.end())
+    {
+        ++_hits;
+        _lru.splice(_lru.begin(), _lru, it->second);
+        return it->second->second;
+    }
+    
+    ++_misses;
+    
+    if(_runs.size() >= _capacity)
+    {
+        _runs.erase(_lru.back().first);
+        _lru.pop_back();
+        ++_evictions;
+    }
+    
+    auto run = make_shared<TextRun>(title, metrics);
+    _lru.emplace_front(key, run);
+    _runs.emplace(move(key), _lru.begin());
+    
+    return run;
+}
+
+size_t TextFitCache::size() const
+{
+    return _runs.size();
+}
+
+size_t TextFitCache::capacity() const
+{
+    return _capacity;
+}
+
+void TextFitCache::clear()
+{
+    _runs.clear();
+    _lru.clear();
+}
+
+uint64_t TextFitCache::hits() const
+{
+    return _hits;
+}
+
+uint64_t TextFitCache::misses() const
+{
+    return _misses;
+}
+
+uint64_t TextFitCache::evictions() const
+{
+    return _evictions;
+}
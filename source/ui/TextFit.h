@@ -0,0 +1,139 @@
+/*---------------------------------------------------------------------------------------------
+ *  Copyright (c) Nicolas Jinchereau. All rights reserved.
+ *  Licensed under the MIT License. See License.txt in the project root for license information.
+ *--------------------------------------------------------------------------------------------*/
+
+#pragma once
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <list>
+#include <memory>
+#include <unordered_map>
+using namespace std;
+
+// Supplies glyph advances for a single font.
+class FontMetrics
+{
+public:
+    virtual ~FontMetrics(){}
+
+    // uniquely identifies the font, including its size
+    virtual const string& fontKey() const = 0;
+
+    virtual float advance(uint32_t codepoint) const = 0;
+};
+
+// Font metrics from a table of advances, with a default for unlisted codepoints.
+class FixedAdvanceMetrics : public FontMetrics
+{
+public:
+    FixedAdvanceMetrics(const string& fontKey, float defaultAdvance);
+
+    void setAdvance(uint32_t codepoint, float advance);
+
+    virtual const string& fontKey() const override;
+    virtual float advance(uint32_t codepoint) const override;
+
+private:
+    string _fontKey;
+    float _defaultAdvance;
+    unordered_map<uint32_t, float> _advances;
+};
+
+// The text to draw for a title at a given width.
+struct TextFit
+{
+    string text;
+    float width = 0;
+    bool truncated = false;
+
+    // unique per fit, so that callers can cache derived objects (ie. NSString)
+    uint64_t serial = 0;
+};
+
+// A title measured once for one font. Fits are cached per width bucket,
+// so that animating a button's width does not re-measure or re-truncate its title.
+class TextRun
+{
+public:
+    // widths are rounded down to a multiple of this before fitting
+    static constexpr float BucketSize = 4.0f;
+
+    // cached fits per run, before they are all dropped
+    static constexpr size_t MaxFits = 64;
+
+    TextRun(const string& text, const FontMetrics& metrics);
+
+    const string& text() const;
+    const string& fontKey() const;
+    float width() const;
+
+    const TextFit& fit(float width);
+    size_t fitCount() const;
+
+    static float ellipsisAdvance(const FontMetrics& metrics);
+
+private:
+    TextFit _computeFit(float width) const;
+
+    string _text;
+    string _fontKey;
+    float _ellipsisWidth;
+
+    // byte offset and total advance after each codepoint
+    vector<uint32_t> _offsets;
+    vector<float> _advances;
+
+    unordered_map<int, TextFit> _fits;
+    TextFit _full;
+};
+
+// LRU cache of measured titles keyed by (title, font).
+class TextFitCache
+{
+public:
+    explicit TextFitCache(size_t capacity = 256);
+
+    // Returns the measured run for 'title', measuring it on a miss.
+    // The returned handle stays valid after the run is evicted.
+    shared_ptr<TextRun> measure(const string& title, const FontMetrics& metrics);
+
+    size_t size() const;
+    size_t capacity() const;
+    void clear();
+
+    uint64_t hits() const;
+    uint64_t misses() const;
+    uint64_t evictions() const;
+
+private:
+    struct Key
+    {
+        string title;
+        string fontKey;
+
+        bool operator==(const Key& other) const {
+            return title == other.title && fontKey == other.fontKey;
+        }
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& key) const {
+            return hash<string>()(key.title) ^ (hash<string>()(key.fontKey) * 31);
+        }
+    };
+
+    typedef list<pair<Key, shared_ptr<TextRun>>> LRU;
+
+    size_t _capacity;
+    LRU _lru;
+    unordered_map<Key, LRU::iterator, KeyHash> _runs;
+    uint64_t _hits;
+    uint64_t _misses;
+    uint64_t _evictions;
+};
+
+// decodes the codepoint at 'i' and advances 'i' past it. Invalid bytes decode as U+FFFD.
+uint32_t decode_utf8(const string& str, size_t& i);
@@ -15,4 +15,5 @@ using namespace std;
 + (NSImage*)iconForHighlightedItem:(NSImage*)icon;
 + (NSImage*)iconWithRotation:(NSImage*)icon angle:(float)angle;
 + (BOOL)isDir:(NSString*)path;
++ (BOOL)writeIcon:(NSImage*)icon toPNG:(NSString*)path size:(CGFloat)size;
 @end
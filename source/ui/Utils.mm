@@ -69,5 +69,28 @@
     return isDir && ![[NSWorkspace sharedWorkspace] isFilePackageAtPath:path];
 }
 
++ (BOOL)writeIcon:(NSImage*)icon toPNG:(NSString*)path size:(CGFloat)size
+{
+    NSBitmapImageRep *rep = [[[NSBitmapImageRep alloc]
+                              initWithBitmapDataPlanes:NULL
+                              pixelsWide:(NSInteger)size
+                              pixelsHigh:(NSInteger)size
+                              bitsPerSample:8
+                              samplesPerPixel:4
+                              hasAlpha:YES
+                              isPlanar:NO
+                              colorSpaceName:NSCalibratedRGBColorSpace
+                              bytesPerRow:0
+                              bitsPerPixel:0] autorelease];
+    
+    [NSGraphicsContext saveGraphicsState];
+    [NSGraphicsContext setCurrentContext:[NSGraphicsContext graphicsContextWithBitmapImageRep:rep]];
+    [icon drawInRect:NSMakeRect(0, 0, size, size) fromRect:NSZeroRect operation:NSCompositeCopy fraction:1.0f];
+    [NSGraphicsContext restoreGraphicsState];
+    
+    NSData *data = [rep representationUsingType:NSPNGFileType properties:@{}];
+    return [data writeToFile:path atomically:YES];
+}
+
 @end
 